@@ -1,28 +1,46 @@
 #include <benchmark/benchmark.h>
 #include <malunal/allocators.hpp>
+#include "counters.hpp"
+
+using malunal::benchmarks::latency_counters;
+using malunal::benchmarks::memory_counters;
 
 static void
 BM_StandardNewDeleteAllocatorCreate(benchmark::State& state) {
+    memory_counters counters;
+
     for (auto _ : state)
         std::vector<int> myvec({ 1, 2, 3 });
+
+    counters.report(state);
 }
 
 static void
 BM_StandardUnsynchronizedPoolCreate(benchmark::State& state) {
     using std::pmr::unsynchronized_pool_resource;
+    memory_counters counters;
     unsynchronized_pool_resource pool;
+    latency_counters latency(&pool);
 
     for (auto _ : state)
-        std::pmr::vector<int> myvec({ 1, 2, 3 }, &pool);
+        std::pmr::vector<int> myvec({ 1, 2, 3 }, latency.resource());
+
+    counters.report(state);
+    latency.report(state);
 }
 
 static void
 BM_MalunalAllocatorsArenaMemoryCreate(benchmark::State& state) {
     using malunal::allocators::arena_memory_resource;
+    memory_counters counters;
     arena_memory_resource arena;
+    latency_counters latency(&arena);
 
     for (auto _ : state)
-        std::pmr::vector<int> myvec({ 1, 2, 3 }, &arena);
+        std::pmr::vector<int> myvec({ 1, 2, 3 }, latency.resource());
+
+    counters.report(state, arena.total_size());
+    latency.report(state);
 }
 
 BENCHMARK(BM_StandardNewDeleteAllocatorCreate)->Iterations(1000000)->Threads(1);
@@ -2,36 +2,53 @@
 #define MALUNAL_ALLOCATORS_ARENA_DEFAULT_CAPACITY    16
 #include <benchmark/benchmark.h>
 #include <malunal/allocators.hpp>
+#include "counters.hpp"
+
+using malunal::benchmarks::latency_counters;
+using malunal::benchmarks::memory_counters;
 
 static void
 BM_StandardNewDeleteAllocatorInsert(benchmark::State& state) {
+    memory_counters counters;
     std::vector<int> myvec;
 
     auto index = 0;
     for (auto _ : state)
         myvec.push_back(index++);
+
+    counters.report(state, 0, myvec.capacity() * sizeof(int));
 }
 
 static void
 BM_StandardUnsynchronizedPoolInsert(benchmark::State& state) {
     using std::pmr::unsynchronized_pool_resource;
+    memory_counters counters;
     unsynchronized_pool_resource pool;
-    std::pmr::vector<int> myvec(&pool);
+    latency_counters latency(&pool);
+    std::pmr::vector<int> myvec(latency.resource());
 
     auto index = 0;
     for (auto _ : state)
         myvec.push_back(index++);
+
+    counters.report(state, 0, myvec.capacity() * sizeof(int));
+    latency.report(state);
 }
 
 static void
 BM_MalunalAllocatorsArenaMemoryInsert(benchmark::State& state) {
     using namespace malunal::allocators;
+    memory_counters counters;
     arena_memory_resource arena;
-    std::pmr::vector<int> myvec(&arena);
+    latency_counters latency(&arena);
+    std::pmr::vector<int> myvec(latency.resource());
 
     auto index = 0;
     for (auto _ : state)
         myvec.push_back(index++);
+
+    counters.report(state, arena.total_size(), myvec.capacity() * sizeof(int));
+    latency.report(state);
 }
 
 BENCHMARK(BM_StandardNewDeleteAllocatorInsert)->Iterations(1000000)->Threads(1);
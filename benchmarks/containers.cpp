@@ -0,0 +1,289 @@
+#include <list>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <benchmark/benchmark.h>
+#include <malunal/allocators.hpp>
+#include "counters.hpp"
+#include "resources.hpp"
+
+using namespace malunal::benchmarks;
+
+// The number of elements in every container, and the number of elements
+// replaced by each churn iteration.
+static constexpr int k_elements = 4096;
+static constexpr int k_churn    = 64;
+
+// Scatters the keys, so the ordered containers aren't built in order.
+static constexpr int
+key(int index) noexcept {
+    return static_cast<int>((static_cast<uint32_t>(index) * 2654435761u) >> 4);
+}
+
+
+// Each model builds, reads and churns one kind of container the way an
+// application would.
+struct pmr_map final {
+    using container = std::pmr::map<int, int>;
+
+    static void
+    build(container& map) {
+        for (auto index = 0; index < k_elements; index++)
+            map.emplace(key(index), index);
+    }
+
+    static int64_t
+    lookup(const container& map) {
+        int64_t result = 0;
+        for (auto index = 0; index < k_elements; index++)
+            result += map.find(key(index))->second;
+        return result;
+    }
+
+    static void
+    churn(container& map, int round) {
+        for (auto index = round; index < round + k_churn; index++) {
+            map.erase(key(index % k_elements));
+            map.emplace(key(index % k_elements), index);
+        }
+    }
+};
+
+struct pmr_unordered_map final {
+    using container = std::pmr::unordered_map<int, int>;
+
+    static void
+    build(container& map) {
+        for (auto index = 0; index < k_elements; index++)
+            map.emplace(key(index), index);
+    }
+
+    static int64_t
+    lookup(const container& map) {
+        int64_t result = 0;
+        for (auto index = 0; index < k_elements; index++)
+            result += map.find(key(index))->second;
+        return result;
+    }
+
+    static void
+    churn(container& map, int round) {
+        for (auto index = round; index < round + k_churn; index++) {
+            map.erase(key(index % k_elements));
+            map.emplace(key(index % k_elements), index);
+        }
+    }
+};
+
+struct pmr_list final {
+    using container = std::pmr::list<int>;
+
+    static void
+    build(container& list) {
+        for (auto index = 0; index < k_elements; index++)
+            list.push_back(index);
+    }
+
+    static int64_t
+    lookup(const container& list) {
+        int64_t result = 0;
+        for (const auto value : list)
+            result += value;
+        return result;
+    }
+
+    static void
+    churn(container& list, int round) {
+        for (auto index = round; index < round + k_churn; index++) {
+            list.pop_front();
+            list.push_back(index);
+        }
+    }
+};
+
+struct pmr_strings final {
+    using container = std::pmr::vector<std::pmr::string>;
+
+    // Lengths from 8 to 134 characters, so most strings outgrow the small
+    // string buffer and allocate.
+    static size_t
+    length(int index) noexcept {
+        return 8 + static_cast<size_t>(index % 127);
+    }
+
+    static void
+    build(container& strings) {
+        for (auto index = 0; index < k_elements; index++)
+            strings.emplace_back(length(index), static_cast<char>('a' + index % 26));
+    }
+
+    static int64_t
+    lookup(const container& strings) {
+        const std::string_view probe = strings[k_elements / 2];
+        int64_t result = 0;
+        for (const auto& string : strings)
+            result += string == probe ? 1 : static_cast<int64_t>(string.size());
+        return result;
+    }
+
+    static void
+    churn(container& strings, int round) {
+        for (auto index = round; index < round + k_churn; index++) {
+            auto& string = strings[static_cast<size_t>(index % k_elements)];
+            string.assign(length(index * 7), 'z');
+            string.shrink_to_fit();
+        }
+    }
+};
+
+struct pmr_nested_vector final {
+    using container = std::pmr::vector<std::pmr::vector<int>>;
+
+    static constexpr int k_inner = 64;
+
+    static void
+    build(container& outer) {
+        for (auto index = 0; index < k_elements / k_inner; index++) {
+            auto& inner = outer.emplace_back();
+            for (auto value = 0; value < k_inner; value++)
+                inner.push_back(value);
+        }
+    }
+
+    static int64_t
+    lookup(const container& outer) {
+        int64_t result = 0;
+        for (const auto& inner : outer) {
+            for (const auto value : inner)
+                result += value;
+        }
+        return result;
+    }
+
+    static void
+    churn(container& outer, int round) {
+        auto& inner = outer[static_cast<size_t>(round) % outer.size()];
+        inner.clear();
+        inner.shrink_to_fit();
+        for (auto value = 0; value < k_inner; value++)
+            inner.push_back(value);
+    }
+};
+
+
+// Builds the container, the destruction is not timed.
+template<typename Model, benchmark_resource Resource>
+static void
+BM_ContainerBuild(benchmark::State& state) {
+    memory_counters counters;
+    Resource resource;
+    for (auto _ : state) {
+        auto container = std::make_unique<typename Model::container>(resource.get());
+        Model::build(*container);
+        benchmark::DoNotOptimize(container->size());
+
+        state.PauseTiming();
+        container.reset();
+        resource.reset();
+        state.ResumeTiming();
+    }
+
+    counters.report(state, mapped_bytes(resource));
+    state.SetItemsProcessed(state.iterations() * k_elements);
+}
+
+// Reads every element of a container built once.
+template<typename Model, benchmark_resource Resource>
+static void
+BM_ContainerLookup(benchmark::State& state) {
+    memory_counters counters;
+    Resource resource;
+    typename Model::container container(resource.get());
+    Model::build(container);
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(Model::lookup(container));
+
+    counters.report(state, mapped_bytes(resource));
+    state.SetItemsProcessed(state.iterations() * k_elements);
+}
+
+// Replaces elements of a container built once, which keeps freeing and
+// allocating memory for as long as the benchmark runs.
+template<typename Model, benchmark_resource Resource>
+    requires Resource::k_reclaims
+static void
+BM_ContainerChurn(benchmark::State& state) {
+    memory_counters counters;
+    Resource resource;
+    typename Model::container container(resource.get());
+    Model::build(container);
+
+    auto round = 0;
+    for (auto _ : state) {
+        Model::churn(container, round);
+        round += k_churn;
+    }
+
+    counters.report(state, mapped_bytes(resource));
+    state.SetItemsProcessed(state.iterations() * k_churn);
+}
+
+// Destroys the container and releases the memory resource, the build is not
+// timed.
+template<typename Model, benchmark_resource Resource>
+static void
+BM_ContainerTeardown(benchmark::State& state) {
+    memory_counters counters;
+    Resource resource;
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto container = std::make_unique<typename Model::container>(resource.get());
+        Model::build(*container);
+        state.ResumeTiming();
+
+        container.reset();
+        resource.reset();
+    }
+
+    counters.report(state, mapped_bytes(resource));
+    state.SetItemsProcessed(state.iterations() * k_elements);
+}
+
+
+#define MALUNAL_CONTAINER_BENCHMARK(Workload, Model, Resource) \
+    BENCHMARK_TEMPLATE(Workload, Model, Resource)->Threads(1)
+
+// The bump allocators never reuse freed memory, so they sit out the churn.
+#define MALUNAL_CONTAINER_BENCHMARKS(Model)                                        \
+    MALUNAL_CONTAINER_BENCHMARK(BM_ContainerBuild, Model, new_delete);             \
+    MALUNAL_CONTAINER_BENCHMARK(BM_ContainerBuild, Model, unsynchronized_pool);    \
+    MALUNAL_CONTAINER_BENCHMARK(BM_ContainerBuild, Model, synchronized_pool);      \
+    MALUNAL_CONTAINER_BENCHMARK(BM_ContainerBuild, Model, monotonic_buffer);       \
+    MALUNAL_CONTAINER_BENCHMARK(BM_ContainerBuild, Model, arena_memory);           \
+    MALUNAL_CONTAINER_BENCHMARK(BM_ContainerBuild, Model, linear_buffer);          \
+    MALUNAL_CONTAINER_BENCHMARK(BM_ContainerBuild, Model, scratch_buffer);         \
+    MALUNAL_CONTAINER_BENCHMARK(BM_ContainerLookup, Model, new_delete);            \
+    MALUNAL_CONTAINER_BENCHMARK(BM_ContainerLookup, Model, unsynchronized_pool);   \
+    MALUNAL_CONTAINER_BENCHMARK(BM_ContainerLookup, Model, synchronized_pool);     \
+    MALUNAL_CONTAINER_BENCHMARK(BM_ContainerLookup, Model, monotonic_buffer);      \
+    MALUNAL_CONTAINER_BENCHMARK(BM_ContainerLookup, Model, arena_memory);          \
+    MALUNAL_CONTAINER_BENCHMARK(BM_ContainerLookup, Model, linear_buffer);         \
+    MALUNAL_CONTAINER_BENCHMARK(BM_ContainerLookup, Model, scratch_buffer);        \
+    MALUNAL_CONTAINER_BENCHMARK(BM_ContainerChurn, Model, new_delete);             \
+    MALUNAL_CONTAINER_BENCHMARK(BM_ContainerChurn, Model, unsynchronized_pool);    \
+    MALUNAL_CONTAINER_BENCHMARK(BM_ContainerChurn, Model, synchronized_pool);      \
+    MALUNAL_CONTAINER_BENCHMARK(BM_ContainerChurn, Model, arena_memory);           \
+    MALUNAL_CONTAINER_BENCHMARK(BM_ContainerTeardown, Model, new_delete);          \
+    MALUNAL_CONTAINER_BENCHMARK(BM_ContainerTeardown, Model, unsynchronized_pool); \
+    MALUNAL_CONTAINER_BENCHMARK(BM_ContainerTeardown, Model, synchronized_pool);   \
+    MALUNAL_CONTAINER_BENCHMARK(BM_ContainerTeardown, Model, monotonic_buffer);    \
+    MALUNAL_CONTAINER_BENCHMARK(BM_ContainerTeardown, Model, arena_memory);        \
+    MALUNAL_CONTAINER_BENCHMARK(BM_ContainerTeardown, Model, linear_buffer);       \
+    MALUNAL_CONTAINER_BENCHMARK(BM_ContainerTeardown, Model, scratch_buffer)
+
+MALUNAL_CONTAINER_BENCHMARKS(pmr_map);
+MALUNAL_CONTAINER_BENCHMARKS(pmr_unordered_map);
+MALUNAL_CONTAINER_BENCHMARKS(pmr_list);
+MALUNAL_CONTAINER_BENCHMARKS(pmr_strings);
+MALUNAL_CONTAINER_BENCHMARKS(pmr_nested_vector);
@@ -0,0 +1,286 @@
+/// @file   counters.hpp
+/// @brief  Provides the memory counters reported by the benchmarks.
+/// @author John Christman sorakatadzuma@gmail.com
+/// @copyright 2024 Malunal Studios, LLC.
+#pragma once
+#include <cstdio>
+#include <cstdlib>
+#include <benchmark/benchmark.h>
+#include <malunal/allocators.hpp>
+
+#if __has_include(<sys/resource.h>)
+#include <sys/resource.h>
+#include <unistd.h>
+#define MALUNAL_BENCHMARKS_HAS_RUSAGE 1
+#else
+#define MALUNAL_BENCHMARKS_HAS_RUSAGE 0
+#endif /* Platform specific headers */
+
+#if defined(__GLIBC__) && \
+    (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+#include <malloc.h>
+#define MALUNAL_BENCHMARKS_HAS_MALLINFO 1
+#else
+#define MALUNAL_BENCHMARKS_HAS_MALLINFO 0
+#endif /* glibc specific headers */
+
+#if __has_include(<linux/perf_event.h>)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define MALUNAL_BENCHMARKS_HAS_PERF_EVENTS 1
+#else
+#define MALUNAL_BENCHMARKS_HAS_PERF_EVENTS 0
+#endif /* Linux specific headers */
+
+
+namespace malunal::benchmarks {
+
+/// @brief   The memory figures of the process at a point in time.
+struct memory_snapshot final {
+    /// @brief The number of minor page faults so far.
+    double minor_faults{0};
+
+    /// @brief The number of major page faults so far.
+    double major_faults{0};
+
+    /// @brief The resident set size of the process in bytes.
+    double resident{0};
+
+    /// @brief The bytes `malloc` has obtained from the operating system.
+    double heap{0};
+
+    /// @brief   Takes a snapshot of the memory figures of the process.
+    /// @details Faults come from `getrusage`, the resident set size from
+    ///          `/proc/self/statm` and the heap from glibc `mallinfo2`; each is 0
+    ///          where it is not available.
+    /// @returns The snapshot.
+    static memory_snapshot
+    take() noexcept {
+        memory_snapshot result;
+    #if MALUNAL_BENCHMARKS_HAS_RUSAGE
+        rusage usage{};
+        if (::getrusage(RUSAGE_SELF, &usage) == 0) {
+            result.minor_faults = static_cast<double>(usage.ru_minflt);
+            result.major_faults = static_cast<double>(usage.ru_majflt);
+        }
+
+        if (auto statm = std::fopen("/proc/self/statm", "r"); statm != nullptr) {
+            unsigned long size = 0;
+            unsigned long pages = 0;
+            if (std::fscanf(statm, "%lu %lu", &size, &pages) == 2)
+                result.resident = static_cast<double>(pages) * static_cast<double>(::sysconf(_SC_PAGESIZE));
+            std::fclose(statm);
+        }
+    #endif /* MALUNAL_BENCHMARKS_HAS_RUSAGE */
+
+    #if MALUNAL_BENCHMARKS_HAS_MALLINFO
+        const auto info = ::mallinfo2();
+        result.heap = static_cast<double>(info.arena + info.hblkhd);
+    #endif /* MALUNAL_BENCHMARKS_HAS_MALLINFO */
+        return result;
+    }
+};
+
+
+/// @brief   Measures the memory cost of a benchmark next to its time.
+/// @details Construct it before the memory resource under test, so that what
+///          the resource maps when it is constructed is counted too, and call
+///          `report()` once the benchmark loop is done, while the resource and
+///          whatever it allocated are still alive. The reported counters are:
+///
+///          - `minor_faults` and `major_faults`, the page faults taken;
+///          - `rss_delta`, how much the resident set size grew;
+///          - `mapped`, the bytes `malloc` obtained from the operating system
+///            plus whatever the resource mapped on its own;
+///          - `wasted`, the mapped bytes not holding requested data.
+struct memory_counters final {
+    memory_counters() noexcept
+        : start_{ memory_snapshot::take() }
+    { }
+
+    /// @brief   Reports the counters of the benchmark.
+    /// @param   state The state of the benchmark to report to.
+    /// @param   mapped The bytes the resource mapped without going through
+    ///          `malloc`, like the regions of an arena.
+    /// @param   requested The bytes requested by the benchmark which are still
+    ///          live.
+    void
+    report(benchmark::State& state, size_t mapped = 0, size_t requested = 0) const noexcept {
+        using benchmark::Counter;
+        const auto stop  = memory_snapshot::take();
+        const auto total = stop.heap - start_.heap + static_cast<double>(mapped);
+
+        state.counters["minor_faults"] = stop.minor_faults - start_.minor_faults;
+        state.counters["major_faults"] = stop.major_faults - start_.major_faults;
+        state.counters["rss_delta"] = Counter(
+            stop.resident - start_.resident,
+            Counter::kDefaults,
+            Counter::kIs1024
+        );
+        state.counters["mapped"] = Counter(total, Counter::kDefaults, Counter::kIs1024);
+        state.counters["wasted"] = Counter(
+            total - static_cast<double>(requested),
+            Counter::kDefaults,
+            Counter::kIs1024
+        );
+    }
+
+private:
+    memory_snapshot start_;
+};
+
+
+/// @brief   Measures the latency of every allocation and deallocation of a
+///          benchmark, reporting the tail instead of the mean.
+/// @details Hand the resource under test to the constructor, and allocate
+///          through `resource()` instead. Timing every operation costs two
+///          clock reads each, so it is a mode of its own: unless the
+///          `MALUNAL_ALLOCATORS_BENCH_LATENCY` variable is set, `resource()`
+///          hands back the resource under test untouched and `report()` does
+///          nothing. Otherwise `report()` emits `alloc_p50`, `alloc_p99`,
+///          `alloc_p999` and `alloc_max`, and the same for `free`, all in
+///          nanoseconds. Rare and huge outliers like an arena mapping a new
+///          region never move the mean, but they always show up in the max.
+struct latency_counters final {
+    /// @brief   Constructs the latency counters for the resource under test.
+    /// @param   upstream The memory resource under test.
+    /// @param   always Whether to measure even without the variable set, for
+    ///          benchmarks which exist to measure latency.
+    explicit
+    latency_counters(std::pmr::memory_resource* upstream, bool always = false) noexcept
+        : timed_{ upstream }
+        , enabled_{ always || requested() }
+    { }
+
+    /// @brief   Provides the memory resource the benchmark should allocate from.
+    /// @returns The timed resource when measuring; the resource under test
+    ///          otherwise.
+    std::pmr::memory_resource*
+    resource() noexcept {
+        return enabled_ ? &timed_ : timed_.upstream_resource();
+    }
+
+    /// @brief   Reports the latency percentiles of the benchmark.
+    /// @param   state The state of the benchmark to report to.
+    void
+    report(benchmark::State& state) const noexcept {
+        if (!enabled_)
+            return;
+
+        const auto stats = timed_.stats();
+        report(state, "alloc", stats.allocate);
+        report(state, "free", stats.deallocate);
+    }
+
+    /// @brief   Checks whether the latency mode was asked for through the
+    ///          `MALUNAL_ALLOCATORS_BENCH_LATENCY` variable.
+    /// @returns True if the variable is set to anything but 0.
+    static bool
+    requested() noexcept {
+        static const bool k_requested = std::invoke([] {
+            const auto value = std::getenv("MALUNAL_ALLOCATORS_BENCH_LATENCY");
+            return value != nullptr && *value != '\0' && std::strcmp(value, "0") != 0;
+        });
+        return k_requested;
+    }
+
+private:
+    allocators::timed_resource timed_;
+    bool                       enabled_;
+
+
+    static void
+    report(
+        benchmark::State&                  state,
+        const std::string&                 name,
+        const allocators::latency_summary& summary
+    ) noexcept {
+        if (summary.count == 0)
+            return;
+
+        state.counters[name + "_p50"]  = static_cast<double>(summary.p50);
+        state.counters[name + "_p99"]  = static_cast<double>(summary.p99);
+        state.counters[name + "_p999"] = static_cast<double>(summary.p999);
+        state.counters[name + "_max"]  = static_cast<double>(summary.max);
+    }
+};
+
+
+/// @brief   Counts the hardware cache misses of the calling thread.
+/// @details The misses are counted through `perf_event_open`, user space only,
+///          between `start()` and `stop()`. Where the counter can't be opened,
+///          which is everywhere but Linux and also Linux with a restrictive
+///          `perf_event_paranoid` or inside most containers, `report()` leaves
+///          the counter out instead of reporting zero misses.
+struct cache_miss_counter final {
+    cache_miss_counter() noexcept {
+    #if MALUNAL_BENCHMARKS_HAS_PERF_EVENTS
+        perf_event_attr attributes{};
+        attributes.type           = PERF_TYPE_HARDWARE;
+        attributes.size           = sizeof(attributes);
+        attributes.config         = PERF_COUNT_HW_CACHE_MISSES;
+        attributes.disabled       = 1;
+        attributes.exclude_kernel = 1;
+        attributes.exclude_hv     = 1;
+        fd_ = static_cast<int>(::syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+    #endif /* MALUNAL_BENCHMARKS_HAS_PERF_EVENTS */
+    }
+
+    cache_miss_counter(const cache_miss_counter& other) = delete;
+
+    cache_miss_counter&
+    operator=(const cache_miss_counter& other) = delete;
+
+    ~cache_miss_counter() noexcept {
+    #if MALUNAL_BENCHMARKS_HAS_PERF_EVENTS
+        if (fd_ != -1)
+            ::close(fd_);
+    #endif /* MALUNAL_BENCHMARKS_HAS_PERF_EVENTS */
+    }
+
+    /// @brief Starts counting from zero.
+    void
+    start() noexcept {
+    #if MALUNAL_BENCHMARKS_HAS_PERF_EVENTS
+        if (fd_ != -1) {
+            ::ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+            ::ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    #endif /* MALUNAL_BENCHMARKS_HAS_PERF_EVENTS */
+    }
+
+    /// @brief Stops counting, keeping the misses counted so far.
+    void
+    stop() noexcept {
+    #if MALUNAL_BENCHMARKS_HAS_PERF_EVENTS
+        if (fd_ != -1)
+            ::ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+    #endif /* MALUNAL_BENCHMARKS_HAS_PERF_EVENTS */
+    }
+
+    /// @brief   Reports the misses counted as `cache_misses`, averaged over the
+    ///          iterations of the benchmark.
+    /// @param   state The state of the benchmark to report to.
+    void
+    report(benchmark::State& state) const noexcept {
+    #if MALUNAL_BENCHMARKS_HAS_PERF_EVENTS
+        uint64_t misses = 0;
+        if (fd_ == -1 || ::read(fd_, &misses, sizeof(misses)) != sizeof(misses))
+            return;
+
+        state.counters["cache_misses"] = benchmark::Counter(
+            static_cast<double>(misses),
+            benchmark::Counter::kAvgIterations
+        );
+    #else
+        (void)state;
+    #endif /* MALUNAL_BENCHMARKS_HAS_PERF_EVENTS */
+    }
+
+private:
+    int fd_{-1};
+};
+
+} // namespace malunal::benchmarks
@@ -0,0 +1,217 @@
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <queue>
+#include <random>
+#include <benchmark/benchmark.h>
+#include <malunal/allocators.hpp>
+#include "counters.hpp"
+#include "resources.hpp"
+
+using namespace malunal::benchmarks;
+
+// The number of allocations made by each run, a few million by default so the
+// free lists settle into their long running shape, which can be raised through
+// the MALUNAL_ALLOCATORS_STRESS_OPERATIONS variable to run for hours.
+static const int64_t k_operations = std::invoke([] {
+    const auto value = std::getenv("MALUNAL_ALLOCATORS_STRESS_OPERATIONS");
+    const auto operations = value != nullptr ? std::atoll(value) : 0;
+    return operations > 0 ? static_cast<int64_t>(operations) : int64_t{1} << 22;
+});
+
+// The number of allocations between two progress reports.
+static constexpr int64_t k_report_interval = int64_t{1} << 15;
+
+// The largest block any distribution asks for.
+static constexpr size_t k_max_block = 64 * 1024;
+
+
+// Sizes spread evenly from 16 bytes to 4 KiB.
+struct uniform_sizes final {
+    static constexpr const char* k_name = "uniform";
+
+    std::uniform_int_distribution<size_t> sizes{ 16, 4096 };
+
+    size_t
+    operator()(std::mt19937_64& engine) {
+        return sizes(engine);
+    }
+};
+
+// Mostly small sizes around 64 bytes with a long tail of large ones, which is
+// what most programs ask for.
+struct log_normal_sizes final {
+    static constexpr const char* k_name = "log_normal";
+
+    std::lognormal_distribution<double> sizes{ std::log(64.0), 1.0 };
+
+    size_t
+    operator()(std::mt19937_64& engine) {
+        return std::clamp(static_cast<size_t>(sizes(engine)), size_t{8}, k_max_block);
+    }
+};
+
+// Mostly small nodes mixed with some large buffers, the mix that leaves the
+// most holes behind.
+struct bimodal_sizes final {
+    static constexpr const char* k_name = "bimodal";
+
+    std::bernoulli_distribution           large{ 0.1 };
+    std::uniform_int_distribution<size_t> small_sizes{ 16, 64 };
+    std::uniform_int_distribution<size_t> large_sizes{ 4096, 16384 };
+
+    size_t
+    operator()(std::mt19937_64& engine) {
+        return large(engine) ? large_sizes(engine) : small_sizes(engine);
+    }
+};
+
+
+// Most blocks die young and a few live for a long time, counted in
+// allocations.
+struct lifetimes final {
+    std::bernoulli_distribution             long_lived{ 0.05 };
+    std::exponential_distribution<double>   short_lifetimes{ 1.0 / 64.0 };
+    std::exponential_distribution<double>   long_lifetimes{ 1.0 / 65536.0 };
+
+    int64_t
+    operator()(std::mt19937_64& engine) {
+        const auto lifetime = long_lived(engine)
+            ? long_lifetimes(engine)
+            : short_lifetimes(engine);
+        return static_cast<int64_t>(lifetime) + 1;
+    }
+};
+
+
+// A live block and the allocation count at which it is freed.
+struct live_block final {
+    int64_t death;
+    void*   ptr;
+    size_t  size;
+
+    bool
+    operator>(const live_block& other) const noexcept {
+        return death > other.death;
+    }
+};
+
+// Reports the progress of the run to the standard error, so the output of the
+// benchmark itself stays machine readable.
+template<typename Sizes, typename Resource>
+static void
+report_progress(
+    Resource& resource,
+    int64_t   operations,
+    double    seconds,
+    size_t    live_blocks
+) {
+    std::fprintf(stderr, "%s/%s: %lld ops, %.0f ops/s, %zu live",
+        Sizes::k_name,
+        Resource::k_name,
+        static_cast<long long>(operations),
+        static_cast<double>(k_report_interval) / seconds,
+        live_blocks);
+
+    if constexpr (std::is_same_v<Resource, arena_memory>) {
+        const auto stats = resource.resource.stats();
+        std::fprintf(stderr, ", %zu free blocks, %zu largest free, %.3f used/mapped",
+            stats.free_blocks,
+            stats.largest_free_block,
+            static_cast<double>(stats.total_used) / static_cast<double>(stats.total_size));
+    }
+
+    std::fprintf(stderr, "\n");
+}
+
+
+// Allocates blocks of random sizes and frees each one once its random lifetime
+// is over, for as many allocations as the run is long. Every report interval
+// the progress is printed, and the counters compare the throughput of the
+// last interval against the first one so the slow down shows up.
+template<typename Sizes, benchmark_resource Resource>
+static void
+BM_FragmentationStress(benchmark::State& state) {
+    memory_counters counters;
+    Resource resource;
+    auto upstream = resource.get();
+
+    std::mt19937_64 engine(0x6d616c756e616cULL);
+    Sizes           sizes;
+    lifetimes       lifetime;
+
+    std::priority_queue<live_block, std::vector<live_block>, std::greater<>> live;
+    size_t  live_bytes = 0;
+    int64_t operation  = 0;
+    double  first_rate = 0.0;
+    double  last_rate  = 0.0;
+
+    auto interval_start = std::chrono::steady_clock::now();
+    for (auto _ : state) {
+        while (!live.empty() && live.top().death <= operation) {
+            const auto block = live.top();
+            live.pop();
+            upstream->deallocate(block.ptr, block.size, alignof(std::max_align_t));
+            live_bytes -= block.size;
+        }
+
+        const auto size = sizes(engine);
+        live.push(live_block{
+            .death = operation + lifetime(engine),
+            .ptr   = upstream->allocate(size, alignof(std::max_align_t)),
+            .size  = size
+        });
+        live_bytes += size;
+
+        if (++operation % k_report_interval == 0) {
+            state.PauseTiming();
+            const std::chrono::duration<double> elapsed =
+                std::chrono::steady_clock::now() - interval_start;
+            last_rate = static_cast<double>(k_report_interval) / elapsed.count();
+            if (first_rate == 0.0)
+                first_rate = last_rate;
+
+            report_progress<Sizes>(resource, operation, elapsed.count(), live.size());
+            state.ResumeTiming();
+            interval_start = std::chrono::steady_clock::now();
+        }
+    }
+
+    size_t mapped = 0;
+    if constexpr (std::is_same_v<Resource, arena_memory>) {
+        const auto stats = resource.resource.stats();
+        mapped = stats.total_size;
+        state.counters["free_blocks"] = static_cast<double>(stats.free_blocks);
+        state.counters["largest_free"] = benchmark::Counter(
+            static_cast<double>(stats.largest_free_block),
+            benchmark::Counter::kDefaults,
+            benchmark::Counter::kIs1024
+        );
+        state.counters["used_ratio"] =
+            static_cast<double>(stats.total_used) / static_cast<double>(stats.total_size);
+    }
+
+    if (first_rate != 0.0)
+        state.counters["slowdown"] = first_rate / last_rate;
+    counters.report(state, mapped, live_bytes);
+    state.SetItemsProcessed(state.iterations());
+
+    while (!live.empty()) {
+        const auto block = live.top();
+        live.pop();
+        upstream->deallocate(block.ptr, block.size, alignof(std::max_align_t));
+    }
+}
+
+
+#define MALUNAL_FRAGMENTATION_BENCHMARKS(Sizes)                                    \
+    BENCHMARK_TEMPLATE(BM_FragmentationStress, Sizes, new_delete)                  \
+        ->Iterations(k_operations)->Threads(1);                                     \
+    BENCHMARK_TEMPLATE(BM_FragmentationStress, Sizes, unsynchronized_pool)         \
+        ->Iterations(k_operations)->Threads(1);                                     \
+    BENCHMARK_TEMPLATE(BM_FragmentationStress, Sizes, arena_memory)                \
+        ->Iterations(k_operations)->Threads(1)
+
+MALUNAL_FRAGMENTATION_BENCHMARKS(uniform_sizes);
+MALUNAL_FRAGMENTATION_BENCHMARKS(log_normal_sizes);
+MALUNAL_FRAGMENTATION_BENCHMARKS(bimodal_sizes);
@@ -0,0 +1,156 @@
+#include <benchmark/benchmark.h>
+#include <malunal/allocators.hpp>
+#include "counters.hpp"
+
+using namespace malunal::allocators;
+using malunal::benchmarks::memory_counters;
+
+// Every cycle allocates this many blocks of the benchmark's block size, then
+// resets the buffer, the way a per-frame or per-request buffer is used.
+static constexpr size_t k_blocks = 1024;
+
+// Large enough for every block of a cycle at the largest block size.
+static constexpr size_t k_buffer_length = 1024 * 1024;
+
+static constexpr size_t k_alignment = alignof(std::max_align_t);
+
+
+// The buffer shared by every benchmark of a run, so that none of them pays for
+// faulting it in while the others don't.
+static std::byte*
+shared_buffer() {
+    alignas(k_alignment) static std::byte k_buffer[k_buffer_length];
+    return k_buffer;
+}
+
+// The smallest bump allocator possible, as written by hand over a plain buffer.
+static void*
+bump(std::byte* buffer, size_t& count, size_t bytes) noexcept {
+    count = (count + k_alignment - 1) & ~(k_alignment - 1);
+    if (count + bytes > k_buffer_length)
+        return nullptr;
+
+    auto result = buffer + count;
+    count += bytes;
+    return result;
+}
+
+
+static void
+BM_StandardNewDeleteCycle(benchmark::State& state) {
+    const auto size = static_cast<size_t>(state.range(0));
+    memory_counters counters;
+    auto resource = std::pmr::new_delete_resource();
+
+    void* blocks[k_blocks];
+    for (auto _ : state) {
+        for (size_t index = 0; index < k_blocks; index++)
+            blocks[index] = resource->allocate(size, k_alignment);
+        benchmark::DoNotOptimize(blocks);
+        for (size_t index = 0; index < k_blocks; index++)
+            resource->deallocate(blocks[index], size, k_alignment);
+    }
+
+    counters.report(state);
+    state.SetItemsProcessed(state.iterations() * k_blocks);
+}
+
+static void
+BM_StandardStackBufferCycle(benchmark::State& state) {
+    const auto size = static_cast<size_t>(state.range(0));
+    memory_counters counters;
+    auto buffer = shared_buffer();
+
+    for (auto _ : state) {
+        size_t count = 0;
+        for (size_t index = 0; index < k_blocks; index++)
+            benchmark::DoNotOptimize(bump(buffer, count, size));
+        benchmark::ClobberMemory();
+    }
+
+    counters.report(state);
+    state.SetItemsProcessed(state.iterations() * k_blocks);
+}
+
+static void
+BM_StandardMonotonicBufferCycle(benchmark::State& state) {
+    const auto size = static_cast<size_t>(state.range(0));
+    memory_counters counters;
+    std::pmr::monotonic_buffer_resource resource(
+        shared_buffer(),
+        k_buffer_length,
+        std::pmr::null_memory_resource()
+    );
+
+    for (auto _ : state) {
+        for (size_t index = 0; index < k_blocks; index++)
+            benchmark::DoNotOptimize(resource.allocate(size, k_alignment));
+        resource.release();
+    }
+
+    counters.report(state);
+    state.SetItemsProcessed(state.iterations() * k_blocks);
+}
+
+static void
+BM_MalunalAllocatorsLinearBufferCycle(benchmark::State& state) {
+    const auto size = static_cast<size_t>(state.range(0));
+    memory_counters counters;
+    linear_buffer_resource resource(shared_buffer(), k_buffer_length);
+    std::pmr::memory_resource* base = &resource;
+
+    for (auto _ : state) {
+        for (size_t index = 0; index < k_blocks; index++)
+            benchmark::DoNotOptimize(base->allocate(size, k_alignment));
+        resource.reset();
+    }
+
+    counters.report(state);
+    state.SetItemsProcessed(state.iterations() * k_blocks);
+}
+
+// The same cycle without the virtual call, through the non-throwing path.
+static void
+BM_MalunalAllocatorsLinearBufferTryCycle(benchmark::State& state) {
+    const auto size = static_cast<size_t>(state.range(0));
+    memory_counters counters;
+    linear_buffer_resource resource(shared_buffer(), k_buffer_length);
+
+    for (auto _ : state) {
+        for (size_t index = 0; index < k_blocks; index++)
+            benchmark::DoNotOptimize(resource.try_allocate(size, k_alignment));
+        resource.reset();
+    }
+
+    counters.report(state);
+    state.SetItemsProcessed(state.iterations() * k_blocks);
+}
+
+// Allocates and frees the blocks in stack order, which a linear buffer in
+// LIFO mode reclaims without any reset.
+static void
+BM_MalunalAllocatorsLinearBufferLifo(benchmark::State& state) {
+    const auto size = static_cast<size_t>(state.range(0));
+    memory_counters counters;
+    linear_buffer_resource resource(shared_buffer(), k_buffer_length, linear_mode::lifo);
+    std::pmr::memory_resource* base = &resource;
+
+    void* blocks[k_blocks];
+    for (auto _ : state) {
+        for (size_t index = 0; index < k_blocks; index++)
+            blocks[index] = base->allocate(size, k_alignment);
+        benchmark::DoNotOptimize(blocks);
+        for (size_t index = k_blocks; index-- > 0;)
+            base->deallocate(blocks[index], size, k_alignment);
+    }
+
+    counters.report(state);
+    state.SetItemsProcessed(state.iterations() * k_blocks);
+}
+
+BENCHMARK(BM_StandardNewDeleteCycle)->RangeMultiplier(4)->Range(16, 1024)->Threads(1);
+BENCHMARK(BM_StandardStackBufferCycle)->RangeMultiplier(4)->Range(16, 1024)->Threads(1);
+BENCHMARK(BM_StandardMonotonicBufferCycle)->RangeMultiplier(4)->Range(16, 1024)->Threads(1);
+BENCHMARK(BM_MalunalAllocatorsLinearBufferCycle)->RangeMultiplier(4)->Range(16, 1024)->Threads(1);
+BENCHMARK(BM_MalunalAllocatorsLinearBufferTryCycle)->RangeMultiplier(4)->Range(16, 1024)->Threads(1);
+BENCHMARK(BM_MalunalAllocatorsLinearBufferLifo)->RangeMultiplier(4)->Range(16, 1024)->Threads(1);
@@ -0,0 +1,253 @@
+#include <numeric>
+#include <random>
+#include <benchmark/benchmark.h>
+#include <malunal/allocators.hpp>
+#include "counters.hpp"
+#include "resources.hpp"
+
+using namespace malunal::benchmarks;
+
+// The number of nodes in every structure, large enough that they don't fit
+// in the L2 cache.
+static constexpr size_t k_nodes = size_t{1} << 16;
+
+
+// Provides the order the nodes are allocated in. In order, node `n` is
+// allocated `n`th; shuffled, the nodes are allocated in a random order, so
+// whatever the resource does the neighbours of a node in the structure are
+// not its neighbours in allocation order.
+static std::vector<size_t>
+allocation_order(bool shuffled) {
+    std::vector<size_t> result(k_nodes);
+    std::iota(result.begin(), result.end(), size_t{0});
+    if (shuffled) {
+        std::mt19937_64 engine(0x6d616c756e616cULL);
+        std::shuffle(result.begin(), result.end(), engine);
+    }
+
+    return result;
+}
+
+// Allocates every node through the resource in the given order, and returns
+// them indexed by their position in the structure.
+template<typename Node>
+static std::vector<Node*>
+allocate_nodes(std::pmr::memory_resource* resource, const std::vector<size_t>& order) {
+    std::vector<Node*> result(k_nodes);
+    for (const auto index : order)
+        result[index] = new (resource->allocate(sizeof(Node), alignof(Node))) Node{};
+    return result;
+}
+
+template<typename Node>
+static void
+deallocate_nodes(std::pmr::memory_resource* resource, const std::vector<Node*>& nodes) {
+    for (auto itr = nodes.rbegin(); itr != nodes.rend(); itr++)
+        resource->deallocate(*itr, sizeof(Node), alignof(Node));
+}
+
+
+// A singly linked list walked from front to back.
+struct linked_list final {
+    struct node final {
+        node*   next;
+        int64_t payload[7];
+    };
+
+    node*              head{nullptr};
+    std::vector<node*> nodes;
+
+    void
+    build(std::pmr::memory_resource* resource, const std::vector<size_t>& order) {
+        nodes = allocate_nodes<node>(resource, order);
+        for (size_t index = 0; index < k_nodes; index++) {
+            nodes[index]->next       = index + 1 < k_nodes ? nodes[index + 1] : nullptr;
+            nodes[index]->payload[0] = static_cast<int64_t>(index);
+        }
+
+        head = nodes.front();
+    }
+
+    int64_t
+    traverse() const noexcept {
+        int64_t result = 0;
+        for (auto temp = head; temp != nullptr; temp = temp->next)
+            result += temp->payload[0];
+        return result;
+    }
+
+    void
+    release(std::pmr::memory_resource* resource) {
+        deallocate_nodes(resource, nodes);
+    }
+};
+
+// A complete binary search tree, searched for every key in a random order.
+struct search_tree final {
+    struct node final {
+        node*   left;
+        node*   right;
+        int64_t key;
+        int64_t payload[5];
+    };
+
+    node*                root{nullptr};
+    std::vector<node*>   nodes;
+    std::vector<int64_t> keys;
+
+    void
+    build(std::pmr::memory_resource* resource, const std::vector<size_t>& order) {
+        // The nodes are laid out as a binary heap, node `n` has the children
+        // `2n + 1` and `2n + 2`, and the keys are assigned in order so it is
+        // a search tree.
+        nodes = allocate_nodes<node>(resource, order);
+        for (size_t index = 0; index < k_nodes; index++) {
+            const auto left  = 2 * index + 1;
+            const auto right = 2 * index + 2;
+            nodes[index]->left  = left  < k_nodes ? nodes[left]  : nullptr;
+            nodes[index]->right = right < k_nodes ? nodes[right] : nullptr;
+        }
+
+        root = nodes.front();
+        int64_t key = 0;
+        assign_keys(root, key);
+
+        keys.resize(k_nodes);
+        std::iota(keys.begin(), keys.end(), int64_t{0});
+        std::shuffle(keys.begin(), keys.end(), std::mt19937_64(k_nodes));
+    }
+
+    int64_t
+    traverse() const noexcept {
+        int64_t result = 0;
+        for (const auto key : keys) {
+            auto temp = root;
+            while (temp != nullptr && temp->key != key)
+                temp = key < temp->key ? temp->left : temp->right;
+            result += temp->payload[0];
+        }
+
+        return result;
+    }
+
+    void
+    release(std::pmr::memory_resource* resource) {
+        deallocate_nodes(resource, nodes);
+    }
+
+private:
+    static void
+    assign_keys(node* temp, int64_t& key) noexcept {
+        if (temp == nullptr)
+            return;
+
+        assign_keys(temp->left, key);
+        temp->key        = key++;
+        temp->payload[0] = temp->key;
+        assign_keys(temp->right, key);
+    }
+};
+
+// A graph shaped like a torus, every node linked to its four neighbours,
+// searched breadth first from the first node.
+struct torus_graph final {
+    static constexpr size_t k_width = 256;
+
+    struct node final {
+        node*    edges[4];
+        uint64_t visited;
+        int64_t  payload[3];
+    };
+
+    std::vector<node*>         nodes;
+    mutable std::vector<node*> queue;
+    mutable uint64_t           generation{0};
+
+    void
+    build(std::pmr::memory_resource* resource, const std::vector<size_t>& order) {
+        nodes = allocate_nodes<node>(resource, order);
+        for (size_t index = 0; index < k_nodes; index++) {
+            const auto row    = index / k_width;
+            const auto column = index % k_width;
+            const auto rows   = k_nodes / k_width;
+            auto& edges = nodes[index]->edges;
+            edges[0] = nodes[row * k_width + (column + 1) % k_width];
+            edges[1] = nodes[row * k_width + (column + k_width - 1) % k_width];
+            edges[2] = nodes[(row + 1) % rows * k_width + column];
+            edges[3] = nodes[(row + rows - 1) % rows * k_width + column];
+            nodes[index]->payload[0] = static_cast<int64_t>(index);
+        }
+
+        queue.reserve(k_nodes);
+    }
+
+    int64_t
+    traverse() const noexcept {
+        int64_t result = 0;
+        generation++;
+        queue.clear();
+        queue.push_back(nodes.front());
+        nodes.front()->visited = generation;
+        for (size_t index = 0; index < queue.size(); index++) {
+            const auto temp = queue[index];
+            result += temp->payload[0];
+            for (const auto edge : temp->edges) {
+                if (edge->visited != generation) {
+                    edge->visited = generation;
+                    queue.push_back(edge);
+                }
+            }
+        }
+
+        return result;
+    }
+
+    void
+    release(std::pmr::memory_resource* resource) {
+        deallocate_nodes(resource, nodes);
+    }
+};
+
+
+// Builds the structure through the resource once, then times walking it. The
+// argument tells whether the nodes were allocated in a shuffled order.
+template<typename Structure, benchmark_resource Resource>
+static void
+BM_PointerChase(benchmark::State& state) {
+    memory_counters counters;
+    Resource resource;
+    Structure structure;
+    structure.build(resource.get(), allocation_order(state.range(0) != 0));
+
+    cache_miss_counter misses;
+    misses.start();
+    for (auto _ : state)
+        benchmark::DoNotOptimize(structure.traverse());
+    misses.stop();
+
+    misses.report(state);
+    counters.report(state, mapped_bytes(resource));
+    state.SetItemsProcessed(state.iterations() * k_nodes);
+
+    // Every other resource releases its memory when it is destroyed, freeing
+    // the nodes one by one would only make the setup slower.
+    if constexpr (std::is_same_v<Resource, new_delete>)
+        structure.release(resource.get());
+}
+
+
+#define MALUNAL_LOCALITY_BENCHMARKS(Structure)                                   \
+    BENCHMARK_TEMPLATE(BM_PointerChase, Structure, new_delete)                   \
+        ->ArgName("shuffled")->Arg(0)->Arg(1)->Threads(1);                        \
+    BENCHMARK_TEMPLATE(BM_PointerChase, Structure, unsynchronized_pool)          \
+        ->ArgName("shuffled")->Arg(0)->Arg(1)->Threads(1);                        \
+    BENCHMARK_TEMPLATE(BM_PointerChase, Structure, monotonic_buffer)             \
+        ->ArgName("shuffled")->Arg(0)->Arg(1)->Threads(1);                        \
+    BENCHMARK_TEMPLATE(BM_PointerChase, Structure, arena_memory)                 \
+        ->ArgName("shuffled")->Arg(0)->Arg(1)->Threads(1);                        \
+    BENCHMARK_TEMPLATE(BM_PointerChase, Structure, linear_buffer)                \
+        ->ArgName("shuffled")->Arg(0)->Arg(1)->Threads(1)
+
+MALUNAL_LOCALITY_BENCHMARKS(linked_list);
+MALUNAL_LOCALITY_BENCHMARKS(search_tree);
+MALUNAL_LOCALITY_BENCHMARKS(torus_graph);
@@ -0,0 +1,238 @@
+#include <benchmark/benchmark.h>
+#include <malunal/allocators.hpp>
+#include "counters.hpp"
+
+using namespace malunal::allocators;
+
+// The number of objects allocated by every benchmark.
+static constexpr size_t k_objects = 4096;
+
+
+// Where the memory behind the requested bytes went. Every figure is in bytes,
+// and a part the resource doesn't expose is left at -1 and not reported.
+struct overhead final {
+    double requested{0};
+    double mapped{0};
+    double padding{-1};
+    double metadata{-1};
+    double slack{-1};
+};
+
+// Reports the overhead relative to the requested bytes, so the parts add up
+// to `mapped_per_byte` minus one.
+static void
+report_overhead(benchmark::State& state, const overhead& result) {
+    using benchmark::Counter;
+    state.counters["mapped"] = Counter(result.mapped, Counter::kDefaults, Counter::kIs1024);
+    state.counters["mapped_per_byte"] = result.mapped / result.requested;
+    if (result.padding >= 0)
+        state.counters["padding_per_byte"] = result.padding / result.requested;
+    if (result.metadata >= 0)
+        state.counters["metadata_per_byte"] = result.metadata / result.requested;
+    if (result.slack >= 0)
+        state.counters["slack_per_byte"] = result.slack / result.requested;
+    state.SetItemsProcessed(state.iterations() * k_objects);
+}
+
+// Keeps track of the bytes a resource obtained from its upstream.
+struct counting_resource : std::pmr::memory_resource {
+    size_t outstanding{0};
+
+protected:
+    void*
+    do_allocate(size_t bytes, size_t alignment) override {
+        outstanding += bytes;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void
+    do_deallocate(void* ptr, size_t bytes, size_t alignment) override {
+        outstanding -= bytes;
+        std::pmr::new_delete_resource()->deallocate(ptr, bytes, alignment);
+    }
+
+    bool
+    do_is_equal(const memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+
+// Rounding up to the usable size of a chunk counts as padding, the chunk
+// headers as metadata. The free space at the top of the heap is shared with
+// the rest of the process, so no slack is reported.
+static void
+BM_StandardMallocOverhead(benchmark::State& state) {
+    const auto size      = static_cast<size_t>(state.range(0));
+    const auto alignment = static_cast<size_t>(state.range(1));
+    auto resource = std::pmr::new_delete_resource();
+
+    overhead result;
+    result.requested = static_cast<double>(k_objects * size);
+
+    std::vector<void*> objects(k_objects);
+    for (auto _ : state) {
+    #if MALUNAL_BENCHMARKS_HAS_MALLINFO
+        const auto before = ::mallinfo2();
+    #endif /* MALUNAL_BENCHMARKS_HAS_MALLINFO */
+        for (auto& object : objects)
+            object = resource->allocate(size, alignment);
+
+    #if MALUNAL_BENCHMARKS_HAS_MALLINFO
+        const auto after = ::mallinfo2();
+        double usable = 0;
+        for (const auto object : objects)
+            usable += static_cast<double>(::malloc_usable_size(object));
+
+        // The heap may have shrunk since the last iteration, so the difference
+        // is taken in doubles rather than wrapping around in unsigned.
+        result.mapped   = static_cast<double>(after.uordblks + after.hblkhd) -
+                          static_cast<double>(before.uordblks + before.hblkhd);
+        result.padding  = usable - result.requested;
+        result.metadata = result.mapped - usable;
+    #endif /* MALUNAL_BENCHMARKS_HAS_MALLINFO */
+
+        for (const auto object : objects)
+            resource->deallocate(object, size, alignment);
+    }
+
+    report_overhead(state, result);
+}
+
+// Only the bytes the pool obtained from its upstream can be seen, so the
+// overhead is not broken down. Whatever the upstream adds on top, like the
+// malloc chunk headers, is not counted either.
+static void
+BM_StandardUnsynchronizedPoolOverhead(benchmark::State& state) {
+    const auto size      = static_cast<size_t>(state.range(0));
+    const auto alignment = static_cast<size_t>(state.range(1));
+
+    overhead result;
+    result.requested = static_cast<double>(k_objects * size);
+    for (auto _ : state) {
+        counting_resource upstream;
+        std::pmr::unsynchronized_pool_resource pool(&upstream);
+        for (size_t index = 0; index < k_objects; index++)
+            benchmark::DoNotOptimize(pool.allocate(size, alignment));
+        result.mapped = static_cast<double>(upstream.outstanding);
+    }
+
+    report_overhead(state, result);
+}
+
+static void
+BM_MalunalAllocatorsNodePoolOverhead(benchmark::State& state) {
+    const auto size      = static_cast<size_t>(state.range(0));
+    const auto alignment = static_cast<size_t>(state.range(1));
+
+    overhead result;
+    result.requested = static_cast<double>(k_objects * size);
+    for (auto _ : state) {
+        counting_resource upstream;
+        node_pool_resource pool(&upstream);
+        for (size_t index = 0; index < k_objects; index++)
+            benchmark::DoNotOptimize(pool.allocate(size, alignment));
+        result.mapped = static_cast<double>(upstream.outstanding);
+    }
+
+    report_overhead(state, result);
+}
+
+// Exposes the free list of the arena, to see where its storage lives.
+struct inspected_arena : arena_memory_resource {
+    using arena_memory_resource::free_list;
+};
+
+// The used spans of the arena are the requested bytes plus their alignment
+// padding, the metadata spans are the region headers and the free list, and
+// the free spans are the slack of the regions. Padding too short to be
+// recorded in front of a block stays on the free list, so free spans shorter
+// than the alignment are padding as well. Once the free list outgrows the
+// space reserved for it in the first region it moves to pages of its own,
+// which are not part of any region, so those pages are added to the metadata
+// and the mapped bytes.
+static void
+BM_MalunalAllocatorsArenaMemoryOverhead(benchmark::State& state) {
+    const auto size      = static_cast<size_t>(state.range(0));
+    const auto alignment = static_cast<size_t>(state.range(1));
+
+    overhead result;
+    result.requested = static_cast<double>(k_objects * size);
+    for (auto _ : state) {
+        inspected_arena arena;
+        for (size_t index = 0; index < k_objects; index++)
+            benchmark::DoNotOptimize(arena.allocate(size, alignment));
+
+        double used = 0;
+        result.metadata = 0;
+        result.slack    = 0;
+        arena.walk([&](const arena_span& span) {
+            const auto bytes = static_cast<double>(span.size);
+            switch (span.kind) {
+            case arena_span_kind::metadata: result.metadata += bytes; break;
+            case arena_span_kind::used:     used            += bytes; break;
+            case arena_span_kind::free:
+                if (span.size < alignment)
+                    used += bytes;
+                else result.slack += bytes;
+                break;
+            }
+        });
+
+        const auto& free_list = arena.free_list();
+        double spilled = 0;
+        if (free_list.capacity() > k_free_list_size) {
+            const auto page  = page_resource::page_size();
+            const auto bytes = free_list.capacity() * sizeof(free_list[0]);
+            spilled = static_cast<double>((bytes + page - 1) / page * page);
+        }
+
+        result.metadata += spilled;
+        result.mapped    = static_cast<double>(arena.total_size()) + spilled;
+        result.padding   = used - result.requested;
+    }
+
+    report_overhead(state, result);
+}
+
+// The buffer is provided by the caller, so only what was consumed of it
+// counts as mapped and all of the overhead is alignment padding.
+static void
+BM_MalunalAllocatorsLinearBufferOverhead(benchmark::State& state) {
+    const auto size      = static_cast<size_t>(state.range(0));
+    const auto alignment = static_cast<size_t>(state.range(1));
+    const auto length    = k_objects * (size + alignment);
+    auto buffer = std::make_unique<std::byte[]>(length);
+
+    overhead result;
+    result.requested = static_cast<double>(k_objects * size);
+    for (auto _ : state) {
+        linear_buffer_resource resource(buffer.get(), length);
+        void* last = nullptr;
+        for (size_t index = 0; index < k_objects; index++)
+            last = resource.allocate(size, alignment);
+
+        const auto consumed = static_cast<std::byte*>(last) + size - buffer.get();
+        result.mapped   = static_cast<double>(consumed);
+        result.padding  = result.mapped - result.requested;
+        result.metadata = 0;
+        result.slack    = 0;
+    }
+
+    report_overhead(state, result);
+}
+
+
+static void
+size_classes(benchmark::internal::Benchmark* bench) {
+    bench->ArgNames({ "size", "align" })->ArgsProduct({
+        { 8, 16, 24, 32, 48, 64, 96, 128, 256, 512, 1024, 4096 },
+        { 8, 16, 64 }
+    })->Iterations(1)->Threads(1);
+}
+
+BENCHMARK(BM_StandardMallocOverhead)->Apply(size_classes);
+BENCHMARK(BM_StandardUnsynchronizedPoolOverhead)->Apply(size_classes);
+BENCHMARK(BM_MalunalAllocatorsNodePoolOverhead)->Apply(size_classes);
+BENCHMARK(BM_MalunalAllocatorsArenaMemoryOverhead)->Apply(size_classes);
+BENCHMARK(BM_MalunalAllocatorsLinearBufferOverhead)->Apply(size_classes);
@@ -0,0 +1,166 @@
+/// @file   resources.hpp
+/// @brief  Provides the memory resources compared by the benchmarks.
+/// @author John Christman sorakatadzuma@gmail.com
+/// @copyright 2024 Malunal Studios, LLC.
+#pragma once
+#include <malunal/allocators.hpp>
+
+
+namespace malunal::benchmarks {
+
+/// @brief   Describes a memory resource under benchmark.
+/// @details Each one owns its memory resource and whatever buffer it needs,
+///          `reset()` is called between iterations that release everything so
+///          the bump allocators can start over, and `k_reclaims` tells whether
+///          deallocated memory can be reused, which workloads that keep
+///          allocating forever need. `k_name` names it in progress output.
+template<typename Resource>
+concept benchmark_resource = requires(Resource& resource) {
+    { resource.get() } -> std::same_as<std::pmr::memory_resource*>;
+    { resource.reset() };
+    { Resource::k_reclaims } -> std::convertible_to<bool>;
+};
+
+
+/// @brief The global `operator new` and `operator delete`.
+struct new_delete final {
+    static constexpr const char* k_name = "new_delete";
+    static constexpr bool k_reclaims = true;
+
+    std::pmr::memory_resource*
+    get() noexcept {
+        return std::pmr::new_delete_resource();
+    }
+
+    void
+    reset() noexcept { }
+};
+
+/// @brief The standard unsynchronized pool resource.
+struct unsynchronized_pool final {
+    static constexpr const char* k_name = "unsynchronized_pool";
+    static constexpr bool k_reclaims = true;
+
+    std::pmr::unsynchronized_pool_resource resource;
+
+    std::pmr::memory_resource*
+    get() noexcept {
+        return &resource;
+    }
+
+    void
+    reset() noexcept { }
+};
+
+/// @brief The standard synchronized pool resource.
+struct synchronized_pool final {
+    static constexpr const char* k_name = "synchronized_pool";
+    static constexpr bool k_reclaims = true;
+
+    std::pmr::synchronized_pool_resource resource;
+
+    std::pmr::memory_resource*
+    get() noexcept {
+        return &resource;
+    }
+
+    void
+    reset() noexcept { }
+};
+
+/// @brief The standard monotonic buffer resource over a fixed buffer.
+struct monotonic_buffer final {
+    static constexpr const char* k_name = "monotonic_buffer";
+    static constexpr bool k_reclaims = false;
+    static constexpr size_t k_length = 64 * 1024 * 1024;
+
+    std::unique_ptr<std::byte[]>        buffer{ new std::byte[k_length] };
+    std::pmr::monotonic_buffer_resource resource{ buffer.get(), k_length };
+
+    std::pmr::memory_resource*
+    get() noexcept {
+        return &resource;
+    }
+
+    void
+    reset() noexcept {
+        resource.release();
+    }
+};
+
+/// @brief The arena memory resource.
+struct arena_memory final {
+    static constexpr const char* k_name = "arena_memory";
+    static constexpr bool k_reclaims = true;
+
+    allocators::arena_memory_resource resource;
+
+    std::pmr::memory_resource*
+    get() noexcept {
+        return &resource;
+    }
+
+    void
+    reset() noexcept { }
+};
+
+/// @brief The linear buffer resource over a fixed buffer.
+struct linear_buffer final {
+    static constexpr const char* k_name = "linear_buffer";
+    static constexpr bool k_reclaims = false;
+    static constexpr size_t k_length = 64 * 1024 * 1024;
+
+    std::unique_ptr<std::byte[]>       buffer{ new std::byte[k_length] };
+    allocators::linear_buffer_resource resource{ buffer.get(), k_length };
+
+    std::pmr::memory_resource*
+    get() noexcept {
+        return &resource;
+    }
+
+    void
+    reset() noexcept {
+        resource.reset();
+    }
+};
+
+/// @brief   The scratch buffer resource over a small fixed buffer, which
+///          overflows into `operator new` for anything larger.
+struct scratch_buffer final {
+    static constexpr const char* k_name = "scratch_buffer";
+    static constexpr bool k_reclaims = false;
+    static constexpr size_t k_length = 256 * 1024;
+
+    std::unique_ptr<std::byte[]>        buffer{ new std::byte[k_length] };
+    allocators::scratch_buffer_resource resource{
+        buffer.get(),
+        k_length,
+        std::pmr::new_delete_resource()
+    };
+
+    std::pmr::memory_resource*
+    get() noexcept {
+        return &resource;
+    }
+
+    void
+    reset() noexcept {
+        resource.reset();
+    }
+};
+
+
+/// @brief   Provides the bytes a memory resource under benchmark mapped on its
+///          own, which `memory_counters` can't see through `malloc`.
+/// @param   resource The memory resource under benchmark.
+/// @returns The bytes of the regions of an arena; 0 for every other resource,
+///          whose memory comes from `malloc`.
+template<benchmark_resource Resource>
+size_t
+mapped_bytes(Resource& resource) noexcept {
+    if constexpr (std::is_same_v<Resource, arena_memory>)
+        return resource.resource.total_size();
+    else return 0;
+}
+
+} // namespace malunal::benchmarks
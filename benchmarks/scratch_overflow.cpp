@@ -0,0 +1,98 @@
+#include <benchmark/benchmark.h>
+#include <malunal/allocators.hpp>
+#include "counters.hpp"
+
+using namespace malunal::allocators;
+using malunal::benchmarks::memory_counters;
+
+// Every cycle allocates the benchmark's number of bytes in blocks of this
+// size, then resets. The scratch buffer holds this many bytes, anything past
+// it overflows to the upstream.
+static constexpr size_t k_block_size     = 64;
+static constexpr size_t k_scratch_length = 16 * 1024;
+static constexpr size_t k_alignment      = alignof(std::max_align_t);
+
+
+static void
+report_throughput(benchmark::State& state) {
+    state.SetItemsProcessed(state.iterations() * (state.range(0) / k_block_size));
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+// Reports how much of every cycle did not fit in the scratch buffer.
+static void
+report_overflow(benchmark::State& state) {
+    const auto total    = static_cast<double>(state.range(0));
+    const auto overflow = std::max(total - static_cast<double>(k_scratch_length), 0.0);
+    state.counters["overflow"] = overflow / total;
+    report_throughput(state);
+}
+
+template<typename Reset>
+static void
+run_cycles(benchmark::State& state, std::pmr::memory_resource* resource, Reset&& reset) {
+    const auto blocks = static_cast<size_t>(state.range(0)) / k_block_size;
+    for (auto _ : state) {
+        for (size_t index = 0; index < blocks; index++)
+            benchmark::DoNotOptimize(resource->allocate(k_block_size, k_alignment));
+        reset();
+    }
+
+    report_overflow(state);
+}
+
+
+// Every block comes from the heap, which the scratch buffer must beat.
+static void
+BM_StandardNewDeleteScratch(benchmark::State& state) {
+    const auto blocks = static_cast<size_t>(state.range(0)) / k_block_size;
+    memory_counters counters;
+    auto resource = std::pmr::new_delete_resource();
+
+    std::vector<void*> pointers(blocks);
+    for (auto _ : state) {
+        for (auto& pointer : pointers)
+            pointer = resource->allocate(k_block_size, k_alignment);
+        benchmark::DoNotOptimize(pointers.data());
+        for (auto pointer : pointers)
+            resource->deallocate(pointer, k_block_size, k_alignment);
+    }
+
+    counters.report(state);
+    report_throughput(state);
+}
+
+static void
+BM_StandardMonotonicBufferScratch(benchmark::State& state) {
+    memory_counters counters;
+    alignas(k_alignment) std::byte buffer[k_scratch_length];
+    std::pmr::monotonic_buffer_resource resource(buffer, sizeof(buffer));
+    run_cycles(state, &resource, [&] { resource.release(); });
+    counters.report(state);
+}
+
+static void
+BM_MalunalAllocatorsScratchBuffer(benchmark::State& state) {
+    memory_counters counters;
+    alignas(k_alignment) std::byte buffer[k_scratch_length];
+    scratch_buffer_resource resource(buffer, sizeof(buffer), std::pmr::new_delete_resource());
+    run_cycles(state, &resource, [&] { resource.reset(); });
+    counters.report(state);
+}
+
+// The overflow buffers come from a pool, which keeps them around between
+// cycles instead of returning them to the heap.
+static void
+BM_MalunalAllocatorsScratchBufferPooled(benchmark::State& state) {
+    memory_counters counters;
+    alignas(k_alignment) std::byte buffer[k_scratch_length];
+    std::pmr::unsynchronized_pool_resource pool;
+    scratch_buffer_resource resource(buffer, sizeof(buffer), &pool);
+    run_cycles(state, &resource, [&] { resource.reset(); });
+    counters.report(state);
+}
+
+BENCHMARK(BM_StandardNewDeleteScratch)->RangeMultiplier(4)->Range(4 << 10, 1 << 20)->Threads(1);
+BENCHMARK(BM_StandardMonotonicBufferScratch)->RangeMultiplier(4)->Range(4 << 10, 1 << 20)->Threads(1);
+BENCHMARK(BM_MalunalAllocatorsScratchBuffer)->RangeMultiplier(4)->Range(4 << 10, 1 << 20)->Threads(1);
+BENCHMARK(BM_MalunalAllocatorsScratchBufferPooled)->RangeMultiplier(4)->Range(4 << 10, 1 << 20)->Threads(1);
@@ -0,0 +1,53 @@
+#include <benchmark/benchmark.h>
+#include <malunal/allocators.hpp>
+#include "counters.hpp"
+#include "resources.hpp"
+
+using namespace malunal::benchmarks;
+
+// The number of blocks every benchmark allocates and keeps alive, enough to
+// make the arena grow by several regions.
+static constexpr int64_t k_blocks = int64_t{1} << 18;
+
+static constexpr size_t
+block_size(size_t index) noexcept {
+    return 16 + (index % 8) * 16;
+}
+
+
+// Allocates a block per iteration and keeps every one of them alive, then
+// frees them all in allocation order once the loop is done. Every operation
+// is timed, so whichever allocation had to grow the resource shows up in
+// `alloc_max` while the mean barely moves.
+template<benchmark_resource Resource>
+static void
+BM_TailLatency(benchmark::State& state) {
+    memory_counters counters;
+    Resource resource;
+    latency_counters latency(resource.get(), true);
+    auto upstream = latency.resource();
+
+    std::vector<void*> blocks;
+    blocks.reserve(static_cast<size_t>(k_blocks));
+    size_t live_bytes = 0;
+    for (auto _ : state) {
+        const auto size = block_size(blocks.size());
+        blocks.push_back(upstream->allocate(size, alignof(std::max_align_t)));
+        live_bytes += size;
+    }
+
+    // Every block is still alive, so this is the most the resource needed.
+    counters.report(state, mapped_bytes(resource), live_bytes);
+
+    for (size_t index = 0; index < blocks.size(); index++)
+        upstream->deallocate(blocks[index], block_size(index), alignof(std::max_align_t));
+
+    if constexpr (std::is_same_v<Resource, arena_memory>)
+        state.counters["region_growths"] = static_cast<double>(resource.resource.stats().region_growths);
+    latency.report(state);
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_TEMPLATE(BM_TailLatency, new_delete)->Iterations(k_blocks)->Threads(1);
+BENCHMARK_TEMPLATE(BM_TailLatency, unsynchronized_pool)->Iterations(k_blocks)->Threads(1);
+BENCHMARK_TEMPLATE(BM_TailLatency, arena_memory)->Iterations(k_blocks)->Threads(1);
@@ -0,0 +1,383 @@
+#include <thread>
+#include <benchmark/benchmark.h>
+#include <malunal/allocators.hpp>
+#include "counters.hpp"
+
+using namespace malunal::allocators;
+using malunal::benchmarks::memory_counters;
+
+// The number of blocks allocated by each thread per iteration, their sizes
+// cycle through the small sizes typical of node based containers.
+static constexpr size_t k_batch = 64;
+
+static constexpr size_t
+block_size(size_t index) noexcept {
+    return 16 + (index % 16) * 16;
+}
+
+static const int k_max_threads = static_cast<int>(
+    std::max(std::thread::hardware_concurrency(), 2u)
+);
+
+
+// Passes every allocation straight to malloc and free.
+struct malloc_resource : std::pmr::memory_resource {
+protected:
+    void*
+    do_allocate(size_t bytes, size_t) override {
+        auto result = std::malloc(bytes);
+        if (result == nullptr)
+            throw std::bad_alloc();
+        return result;
+    }
+
+    void
+    do_deallocate(void* ptr, size_t, size_t) override {
+        std::free(ptr);
+    }
+
+    bool
+    do_is_equal(const memory_resource& other) const noexcept override {
+        return dynamic_cast<const malloc_resource*>(&other) != nullptr;
+    }
+};
+
+// Serializes every allocation into a single upstream behind a mutex.
+struct locked_resource : std::pmr::memory_resource {
+    explicit
+    locked_resource(std::pmr::memory_resource* upstream)
+        : upstream_{ upstream }
+    { }
+
+protected:
+    void*
+    do_allocate(size_t bytes, size_t alignment) override {
+        std::lock_guard lock(mutex_);
+        return upstream_->allocate(bytes, alignment);
+    }
+
+    void
+    do_deallocate(void* ptr, size_t bytes, size_t alignment) override {
+        std::lock_guard lock(mutex_);
+        upstream_->deallocate(ptr, bytes, alignment);
+    }
+
+    bool
+    do_is_equal(const memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+private:
+    std::pmr::memory_resource* upstream_;
+    std::mutex                 mutex_;
+};
+
+// Spreads the threads over several arenas, each behind its own mutex. Every
+// block records the shard it came from in front of it, so a block freed by
+// another thread goes straight back to the arena that owns it.
+struct sharded_arena_resource : std::pmr::memory_resource {
+    static constexpr size_t k_shards = 16;
+
+    // The bytes mapped by all of the shards together.
+    size_t
+    total_size() {
+        size_t result = 0;
+        for (auto& shard : shards_) {
+            std::lock_guard lock(shard.mutex);
+            result += shard.arena.total_size();
+        }
+
+        return result;
+    }
+
+protected:
+    void*
+    do_allocate(size_t bytes, size_t alignment) override {
+        const auto index  = shard_index();
+        const auto header = header_size(alignment);
+        auto& shard = shards_[index];
+        std::lock_guard lock(shard.mutex);
+        auto block = static_cast<std::byte*>(shard.arena.allocate(bytes + header, alignment));
+        *reinterpret_cast<size_t*>(block + header - sizeof(size_t)) = index;
+        return block + header;
+    }
+
+    void
+    do_deallocate(void* ptr, size_t bytes, size_t alignment) override {
+        const auto header = header_size(alignment);
+        const auto index  = *reinterpret_cast<size_t*>(static_cast<std::byte*>(ptr) - sizeof(size_t));
+        const auto block  = static_cast<std::byte*>(ptr) - header;
+        assert(index < k_shards);
+
+        auto& shard = shards_[index];
+        std::lock_guard lock(shard.mutex);
+        assert(shard.arena.owns(block));
+        shard.arena.deallocate(block, bytes + header, alignment);
+    }
+
+    bool
+    do_is_equal(const memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+private:
+    struct shard final {
+        std::mutex            mutex;
+        arena_memory_resource arena;
+    };
+
+    std::array<shard, k_shards> shards_;
+
+    // The space in front of every block, keeping the block itself aligned.
+    static constexpr size_t
+    header_size(size_t alignment) noexcept {
+        return std::max(alignment, sizeof(size_t));
+    }
+
+    static size_t
+    shard_index() noexcept {
+        static std::atomic<size_t> k_next_shard{0};
+        thread_local const size_t k_shard = k_next_shard++ % k_shards;
+        return k_shard;
+    }
+};
+
+
+// The shared resources live for the whole run, so that every thread of a
+// benchmark sees the same instance without any setup or teardown races.
+static std::pmr::memory_resource*
+shared_malloc() {
+    static malloc_resource k_resource;
+    return &k_resource;
+}
+
+static std::pmr::memory_resource*
+shared_synchronized_pool() {
+    static std::pmr::synchronized_pool_resource k_resource;
+    return &k_resource;
+}
+
+static arena_memory_resource*
+locked_arena() {
+    static arena_memory_resource k_arena;
+    return &k_arena;
+}
+
+static std::pmr::memory_resource*
+shared_locked_arena() {
+    static locked_resource k_resource(locked_arena());
+    return &k_resource;
+}
+
+static sharded_arena_resource*
+shared_sharded_arena() {
+    static sharded_arena_resource k_resource;
+    return &k_resource;
+}
+
+static std::pmr::memory_resource*
+own_thread_arena() {
+    return thread_arena_instance();
+}
+
+
+// Provides the bytes a resource mapped without going through `malloc`.
+using mapped_size = size_t (*)(benchmark::State& state);
+
+static size_t
+no_mapped_size(benchmark::State&) {
+    return 0;
+}
+
+static size_t
+locked_arena_size(benchmark::State&) {
+    return locked_arena()->total_size();
+}
+
+static size_t
+sharded_arena_size(benchmark::State&) {
+    return shared_sharded_arena()->total_size();
+}
+
+// Every thread runs the same batches, so each thread arena maps as much as
+// the one of the reporting thread.
+static size_t
+thread_arena_size(benchmark::State& state) {
+    return thread_arena_instance()->total_size() * static_cast<size_t>(state.threads());
+}
+
+// The memory counters are taken for the whole process, so only the first
+// thread reports them.
+static void
+report_memory(benchmark::State& state, const memory_counters& counters, mapped_size mapped) {
+    if (state.thread_index() == 0)
+        counters.report(state, mapped(state));
+}
+
+
+// Each thread allocates a batch of blocks and frees them again.
+static void
+churn(benchmark::State& state, std::pmr::memory_resource* resource, mapped_size mapped) {
+    memory_counters counters;
+    void* blocks[k_batch];
+    for (auto _ : state) {
+        for (size_t index = 0; index < k_batch; index++)
+            blocks[index] = resource->allocate(block_size(index), 8);
+        for (size_t index = 0; index < k_batch; index++)
+            resource->deallocate(blocks[index], block_size(index), 8);
+    }
+
+    report_memory(state, counters, mapped);
+    state.SetItemsProcessed(state.iterations() * k_batch);
+}
+
+// Each thread allocates a batch of blocks, hands them to the other threads
+// through a shared queue and frees whatever the other threads handed over, so
+// most blocks are freed by a thread other than the one that allocated them.
+static void
+handoff(benchmark::State& state, std::pmr::memory_resource* resource, mapped_size mapped) {
+    struct block final {
+        void*  ptr;
+        size_t size;
+    };
+
+    static std::mutex         k_mutex;
+    static std::vector<block> k_queue;
+
+    memory_counters counters;
+    std::vector<block> local;
+    local.reserve(k_batch);
+    for (auto _ : state) {
+        for (size_t index = 0; index < k_batch; index++)
+            local.push_back(block{ resource->allocate(block_size(index), 8), block_size(index) });
+
+        {
+            std::lock_guard lock(k_mutex);
+            k_queue.insert(k_queue.end(), local.begin(), local.end());
+            local.clear();
+
+            // Take the oldest blocks, which most likely came from another thread.
+            const auto count = std::min(k_batch, k_queue.size());
+            local.assign(k_queue.begin(), k_queue.begin() + count);
+            k_queue.erase(k_queue.begin(), k_queue.begin() + count);
+        }
+
+        for (const auto& entry : local)
+            resource->deallocate(entry.ptr, entry.size, 8);
+        local.clear();
+    }
+
+    // Every thread is past its loop by now, the first one frees whatever was
+    // left in the queue.
+    if (state.thread_index() == 0) {
+        std::lock_guard lock(k_mutex);
+        for (const auto& entry : k_queue)
+            resource->deallocate(entry.ptr, entry.size, 8);
+        k_queue.clear();
+    }
+
+    report_memory(state, counters, mapped);
+    state.SetItemsProcessed(state.iterations() * k_batch);
+}
+
+// Each thread keeps a working set of blocks alive and replaces one at a time,
+// so every thread hits the shared resource on every operation.
+static void
+contend(benchmark::State& state, std::pmr::memory_resource* resource, mapped_size mapped) {
+    memory_counters counters;
+    std::array<void*, k_batch> blocks;
+    for (size_t index = 0; index < k_batch; index++)
+        blocks[index] = resource->allocate(block_size(index), 8);
+
+    size_t index = 0;
+    for (auto _ : state) {
+        resource->deallocate(blocks[index], block_size(index), 8);
+        blocks[index] = resource->allocate(block_size(index), 8);
+        index = (index + 1) % k_batch;
+    }
+
+    for (index = 0; index < k_batch; index++)
+        resource->deallocate(blocks[index], block_size(index), 8);
+    report_memory(state, counters, mapped);
+    state.SetItemsProcessed(state.iterations());
+}
+
+
+static void
+BM_StandardMallocChurn(benchmark::State& state) {
+    churn(state, shared_malloc(), no_mapped_size);
+}
+
+static void
+BM_StandardSynchronizedPoolChurn(benchmark::State& state) {
+    churn(state, shared_synchronized_pool(), no_mapped_size);
+}
+
+static void
+BM_MalunalAllocatorsLockedArenaChurn(benchmark::State& state) {
+    churn(state, shared_locked_arena(), locked_arena_size);
+}
+
+static void
+BM_MalunalAllocatorsShardedArenaChurn(benchmark::State& state) {
+    churn(state, shared_sharded_arena(), sharded_arena_size);
+}
+
+static void
+BM_MalunalAllocatorsThreadArenaChurn(benchmark::State& state) {
+    churn(state, own_thread_arena(), thread_arena_size);
+}
+
+static void
+BM_StandardMallocHandoff(benchmark::State& state) {
+    handoff(state, shared_malloc(), no_mapped_size);
+}
+
+static void
+BM_StandardSynchronizedPoolHandoff(benchmark::State& state) {
+    handoff(state, shared_synchronized_pool(), no_mapped_size);
+}
+
+static void
+BM_MalunalAllocatorsLockedArenaHandoff(benchmark::State& state) {
+    handoff(state, shared_locked_arena(), locked_arena_size);
+}
+
+static void
+BM_MalunalAllocatorsShardedArenaHandoff(benchmark::State& state) {
+    handoff(state, shared_sharded_arena(), sharded_arena_size);
+}
+
+static void
+BM_StandardMallocContend(benchmark::State& state) {
+    contend(state, shared_malloc(), no_mapped_size);
+}
+
+static void
+BM_StandardSynchronizedPoolContend(benchmark::State& state) {
+    contend(state, shared_synchronized_pool(), no_mapped_size);
+}
+
+static void
+BM_MalunalAllocatorsLockedArenaContend(benchmark::State& state) {
+    contend(state, shared_locked_arena(), locked_arena_size);
+}
+
+static void
+BM_MalunalAllocatorsShardedArenaContend(benchmark::State& state) {
+    contend(state, shared_sharded_arena(), sharded_arena_size);
+}
+
+BENCHMARK(BM_StandardMallocChurn)->ThreadRange(1, k_max_threads)->UseRealTime();
+BENCHMARK(BM_StandardSynchronizedPoolChurn)->ThreadRange(1, k_max_threads)->UseRealTime();
+BENCHMARK(BM_MalunalAllocatorsLockedArenaChurn)->ThreadRange(1, k_max_threads)->UseRealTime();
+BENCHMARK(BM_MalunalAllocatorsShardedArenaChurn)->ThreadRange(1, k_max_threads)->UseRealTime();
+BENCHMARK(BM_MalunalAllocatorsThreadArenaChurn)->ThreadRange(1, k_max_threads)->UseRealTime();
+BENCHMARK(BM_StandardMallocHandoff)->ThreadRange(1, k_max_threads)->UseRealTime();
+BENCHMARK(BM_StandardSynchronizedPoolHandoff)->ThreadRange(1, k_max_threads)->UseRealTime();
+BENCHMARK(BM_MalunalAllocatorsLockedArenaHandoff)->ThreadRange(1, k_max_threads)->UseRealTime();
+BENCHMARK(BM_MalunalAllocatorsShardedArenaHandoff)->ThreadRange(1, k_max_threads)->UseRealTime();
+BENCHMARK(BM_StandardMallocContend)->ThreadRange(1, k_max_threads)->UseRealTime();
+BENCHMARK(BM_StandardSynchronizedPoolContend)->ThreadRange(1, k_max_threads)->UseRealTime();
+BENCHMARK(BM_MalunalAllocatorsLockedArenaContend)->ThreadRange(1, k_max_threads)->UseRealTime();
+BENCHMARK(BM_MalunalAllocatorsShardedArenaContend)->ThreadRange(1, k_max_threads)->UseRealTime();
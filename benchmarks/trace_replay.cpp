@@ -0,0 +1,91 @@
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <benchmark/benchmark.h>
+#include <malunal/allocators.hpp>
+#include "counters.hpp"
+
+using namespace malunal::allocators;
+using malunal::benchmarks::memory_counters;
+
+// Records a synthetic trace of some typical container usage, used whenever no
+// trace file is provided through the MALUNAL_ALLOCATORS_TRACE_FILE variable.
+static std::vector<trace_record>
+record_synthetic_trace() {
+    auto file = std::tmpfile();
+    {
+        recording_resource recorder(std::pmr::new_delete_resource(), file);
+        for (auto round = 0; round < 16; round++) {
+            std::pmr::map<int, std::pmr::string> map(&recorder);
+            std::pmr::vector<int> vec(&recorder);
+            for (auto index = 0; index < 256; index++) {
+                map.emplace(index, std::pmr::string(64, 'x', &recorder));
+                vec.push_back(index);
+            }
+        }
+    }
+
+    std::rewind(file);
+    auto result = read_trace(file);
+    std::fclose(file);
+    return result;
+}
+
+static const std::vector<trace_record>&
+trace_records() {
+    static const auto k_records = std::invoke([] {
+        const auto path = std::getenv("MALUNAL_ALLOCATORS_TRACE_FILE");
+        return path != nullptr ? read_trace(path) : record_synthetic_trace();
+    });
+    return k_records;
+}
+
+template<typename Resource>
+static void
+replay_trace_on(benchmark::State& state, Resource& resource) {
+    const auto& records = trace_records();
+    for (auto _ : state)
+        benchmark::DoNotOptimize(replay_trace(records, &resource));
+    state.SetItemsProcessed(state.iterations() * records.size());
+}
+
+static void
+BM_StandardNewDeleteReplay(benchmark::State& state) {
+    trace_records();
+    memory_counters counters;
+    replay_trace_on(state, *std::pmr::new_delete_resource());
+    counters.report(state);
+}
+
+static void
+BM_StandardUnsynchronizedPoolReplay(benchmark::State& state) {
+    trace_records();
+    memory_counters counters;
+    std::pmr::unsynchronized_pool_resource pool;
+    replay_trace_on(state, pool);
+    counters.report(state);
+}
+
+static void
+BM_MalunalAllocatorsArenaMemoryReplay(benchmark::State& state) {
+    trace_records();
+    memory_counters counters;
+    arena_memory_resource arena;
+    replay_trace_on(state, arena);
+    counters.report(state, arena.total_size());
+}
+
+static void
+BM_MalunalAllocatorsNodePoolReplay(benchmark::State& state) {
+    trace_records();
+    memory_counters counters;
+    arena_memory_resource arena;
+    node_pool_resource pool(&arena);
+    replay_trace_on(state, pool);
+    counters.report(state, arena.total_size());
+}
+
+BENCHMARK(BM_StandardNewDeleteReplay)->Threads(1);
+BENCHMARK(BM_StandardUnsynchronizedPoolReplay)->Threads(1);
+BENCHMARK(BM_MalunalAllocatorsArenaMemoryReplay)->Threads(1);
+BENCHMARK(BM_MalunalAllocatorsNodePoolReplay)->Threads(1);
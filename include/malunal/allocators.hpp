@@ -6,4 +6,16 @@
 #include "allocators/common.hpp"
 #include "allocators/linear.hpp"
 #include "allocators/scratch.hpp"
+#include "allocators/hooks.hpp"
+#include "allocators/page.hpp"
+#include "allocators/composite.hpp"
 #include "allocators/arena.hpp"
+#include "allocators/thread_cache.hpp"
+#include "allocators/node_pool.hpp"
+#include "allocators/trace.hpp"
+#include "allocators/profiler.hpp"
+#include "allocators/latency.hpp"
+#include "allocators/tagging.hpp"
+#include "allocators/timeline.hpp"
+#include "allocators/coroutine.hpp"
+#include "allocators/pointers.hpp"
@@ -5,15 +5,6 @@
 #pragma once
 
 
-#if MALUNAL_ALLOCATORS_PLATFORM_POSIX
-#include <sys/mman.h>
-#elif MALUNAL_ALLOCATORS_PLATFORM_WIN32
-#define WIN32_LEAN_AND_MEAN 1
-#define NOMINMAX 1
-#include <windows.h>
-#endif /* Platform specific headers */
-
-
 // Set maximum allocation size if not yet set.
 #ifndef MALUNAL_ALLOCATORS_REGION_MAXIMUM_ALLOCATION
 /// @def     MALUNAL_ALLOCATORS_REGION_MAXIMUM_ALLOCATION
@@ -52,12 +43,10 @@
 ///          the arena does it's job properly and you use the memory properly.
 ///          This value is a way to preallocate the arena to store the number
 ///          you need. Otherwise, the list will reallocate everytime it needs
-///          more space and that will cause it to wander around the memory of
-///          the allocator which may be undesirable.
-/// @note    The free list has no ability to corrupt the arena memory! The
-///          cause for it to reallocate and wander is a consequence of using
-///          the standard library `vector` as it will allocate a new block
-///          before deallocating the previous.
+///          more space, moving out of the initial region and into pages mapped
+///          directly from the operating system.
+/// @note    The free list has no ability to corrupt the arena memory! It never
+///          reallocates into the regions of the arena itself.
 #define MALUNAL_ALLOCATORS_ARENA_FREE_LIST_SIZE 32
 #elif MALUNAL_ALLOCATORS_ARENA_FREE_LIST_SIZE < 8 || \
       MALUNAL_ALLOCATORS_ARENA_FREE_LIST_SIZE > 256
@@ -86,6 +75,128 @@ inline static constexpr size_t
 k_free_list_size = MALUNAL_ALLOCATORS_ARENA_FREE_LIST_SIZE;
 
 
+/// @brief   The number of size classes in the arena statistics histograms.
+/// @details Size class `n` counts the blocks larger than `2^(n-1)` bytes and at
+///          most `2^n` bytes, the last class counts everything larger.
+inline static constexpr size_t
+k_stats_size_classes = 48;
+
+
+/// @brief   A snapshot of the statistics of an arena memory resource.
+/// @details Taken through `arena_memory_resource::stats()`. The snapshot is
+///          a plain copy, so it stays unchanged while the arena keeps being
+///          used and can be compared against later snapshots.
+struct arena_stats final {
+    using histogram = std::array<size_t, k_stats_size_classes>;
+
+    /// @brief The amount of memory handed out, including the arena metadata.
+    size_t total_used{0};
+
+    /// @brief The amount of memory acquired from the operating system.
+    size_t total_size{0};
+
+    /// @brief The number of regions acquired from the operating system.
+    size_t total_regions{0};
+
+    /// @brief The number of live allocations, including the free list.
+    size_t allocations{0};
+
+    /// @brief The highest `total_used` seen since the arena was created.
+    size_t peak_used{0};
+
+    /// @brief The number of blocks in the free list.
+    size_t free_blocks{0};
+
+    /// @brief The amount of memory in all of the free blocks combined.
+    size_t free_bytes{0};
+
+    /// @brief The size of the largest free block.
+    size_t largest_free_block{0};
+
+    /// @brief   The external fragmentation of the free memory.
+    /// @details Computed as `1 - largest_free_block / free_bytes`, 0 means all
+    ///          free memory is one block and values close to 1 mean the free
+    ///          memory is scattered across many small blocks.
+    double fragmentation{0.0};
+
+    /// @brief The number of regions acquired after construction.
+    size_t region_growths{0};
+
+    /// @brief The number of live allocations per size class.
+    histogram live_blocks{};
+
+    /// @brief The number of free blocks per size class.
+    histogram free_block_sizes{};
+
+    /// @brief   Provides the size class of the given size in bytes.
+    /// @param   bytes The size to classify.
+    /// @returns The index of the size class into the histograms.
+    static constexpr size_t
+    size_class(size_t bytes) noexcept {
+        const auto index = bytes < 2 ? 0 : static_cast<size_t>(std::bit_width(bytes - 1));
+        return std::min(index, k_stats_size_classes - 1);
+    }
+};
+
+
+/// @brief   The memory of an arena memory resource as the operating system
+///          sees it, taken through `arena_memory_resource::memory_usage()`.
+/// @details Unlike `total_used()` and `total_size()`, which count what the arena
+///          hands out and maps, this tells how much of that memory actually
+///          costs the process. Regions are mapped readable and writable in one
+///          go, so every reserved byte is committed as well; the resident bytes
+///          are the pages the operating system really backs with memory, which
+///          is what the RSS of the process is made of.
+struct arena_memory_usage final {
+    /// @brief The address space reserved for the regions.
+    size_t reserved{0};
+
+    /// @brief The memory committed for the regions.
+    size_t committed{0};
+
+    /// @brief   The memory of the regions that is resident.
+    /// @details Only measured on POSIX platforms through `mincore`, and only
+    ///          when asked for; 0 otherwise.
+    size_t resident{0};
+
+    /// @brief The number of pages returned to the operating system by the last
+    ///        purge.
+    size_t purged_pages{0};
+
+    /// @brief The number of bytes in those purged pages.
+    size_t purged_bytes{0};
+};
+
+
+/// @brief   The kind of memory a span of an arena region holds.
+enum class arena_span_kind : uint8_t {
+    /// @brief The region header, or the free list stored in the first region.
+    metadata,
+
+    /// @brief A block on the free list.
+    free,
+
+    /// @brief Memory handed out by the arena, including alignment padding.
+    used
+};
+
+/// @brief   A contiguous span of memory within one of the regions of an arena,
+///          as reported by `arena_memory_resource::walk()`.
+struct arena_span final {
+    /// @brief The index of the region the span is in, in acquisition order.
+    size_t region{0};
+
+    /// @brief The address of the first byte of the span.
+    uintptr_t addr{0};
+
+    /// @brief The size of the span in bytes.
+    size_t size{0};
+
+    /// @brief What the span holds.
+    arena_span_kind kind{arena_span_kind::used};
+};
+
+
 /// @brief   A memory resource for managing regions of virtual memory acquired
 ///          from the operating system.
 /// @details Manages the acquisition, initialization, and release of virtual
@@ -106,13 +217,43 @@ struct arena_memory_resource : std::pmr::memory_resource {
     explicit
     arena_memory_resource(size_t capacity = k_default_capacity)
         : linbufres_()
-        , free_list_(&linbufres_)
+        , listres_(&linbufres_, page_allocator_instance())
+        , free_list_(&listres_)
     {
         constexpr size_t mebibytes = 1048576;
         capacity *= mebibytes;
         vmem_acquire(capacity);
     }
 
+#if MALUNAL_ALLOCATORS_ENABLE_HOOKS
+    /// @brief   Initializes the arena memory resource with the given allocation
+    ///          hooks already installed.
+    /// @details Unlike installing the hooks through `set_hooks()`, this also
+    ///          reports the regions acquired while the arena is constructed.
+    /// @param   hooks The allocation hooks to install.
+    /// @param   capacity The initial capacity of the arena memory resource
+    ///          measured in MiB (mebibytes).
+    explicit
+    arena_memory_resource(
+        const allocation_hooks& hooks,
+        size_t capacity = k_default_capacity
+    )
+        : linbufres_()
+        , listres_(&linbufres_, page_allocator_instance())
+        , free_list_(&listres_)
+        , hooks_{ hooks }
+    {
+        constexpr size_t mebibytes = 1048576;
+        capacity *= mebibytes;
+        vmem_acquire(capacity);
+    }
+#endif /* MALUNAL_ALLOCATORS_ENABLE_HOOKS */
+
+    arena_memory_resource(const arena_memory_resource& other) = delete;
+
+    arena_memory_resource&
+    operator=(const arena_memory_resource& other) = delete;
+
     /// @brief   Releases the arena memory resource by releasing all of the
     ///          regions in the linked list of the memory managed by this
     ///          resource.
@@ -169,6 +310,232 @@ struct arena_memory_resource : std::pmr::memory_resource {
         return allocations_;
     }
 
+    /// @brief   Finds a free block to allocate the number of bytes specified,
+    ///          without throwing.
+    /// @details This is the allocation path used by `do_allocate()`. When no
+    ///          free block fits the allocation, a new region is acquired from
+    ///          the operating system, and if that fails as well `nullptr` is
+    ///          returned instead of throwing `std::bad_alloc`.
+    /// @param   bytes The number of bytes that need to be allocated.
+    /// @param   alignment The alignment of the object to be allocated.
+    /// @returns A pointer to the memory which the object can be placed into,
+    ///          or `nullptr` if no memory could be obtained.
+    void*
+    try_allocate(size_t bytes, size_t alignment) noexcept {
+        return vmem_allocate_region(bytes, alignment);
+    }
+
+#if MALUNAL_ALLOCATORS_ENABLE_HOOKS
+    /// @brief   Installs the given allocation hooks into this arena.
+    /// @details Replaces any previously installed hooks. Whatever the hooks
+    ///          point to must outlive the arena, or be replaced before it is
+    ///          destroyed, because releasing the regions is reported as well.
+    /// @param   hooks The allocation hooks to install.
+    void
+    set_hooks(const allocation_hooks& hooks) noexcept {
+        hooks_ = hooks;
+    }
+
+    /// @brief   Provides the allocation hooks installed in this arena.
+    /// @returns The installed allocation hooks.
+    const allocation_hooks&
+    hooks() const noexcept {
+        return hooks_;
+    }
+#endif /* MALUNAL_ALLOCATORS_ENABLE_HOOKS */
+
+    /// @brief   Provides a snapshot of the statistics of this arena.
+    /// @details The counters kept by the arena are copied as they are, and the
+    ///          free block figures are computed by walking the free list, so
+    ///          taking a snapshot costs as much as the free list is long.
+    /// @returns The statistics of this arena at the time of the call.
+    arena_stats
+    stats() const noexcept {
+        arena_stats result {
+            .total_used     = total_used_,
+            .total_size     = total_size_,
+            .total_regions  = total_regions_,
+            .allocations    = allocations_,
+            .peak_used      = peak_used_,
+            .free_blocks    = free_list_.size(),
+            .region_growths = region_growths_,
+            .live_blocks    = live_blocks_
+        };
+
+        for (const auto& block : free_list_) {
+            result.free_bytes += block.size;
+            result.largest_free_block = std::max(result.largest_free_block, block.size);
+            result.free_block_sizes[arena_stats::size_class(block.size)]++;
+        }
+
+        if (result.free_bytes != 0) {
+            const auto largest = static_cast<double>(result.largest_free_block);
+            result.fragmentation = 1.0 - largest / static_cast<double>(result.free_bytes);
+        }
+
+        return result;
+    }
+
+    /// @brief   Provides the reserved, committed and resident memory of the
+    ///          regions of this arena, and how much of it was purged.
+    /// @details Measuring the resident memory asks the operating system about
+    ///          every page of every region, once per region through `mincore`,
+    ///          so it is optional.
+    /// @param   measure_resident Whether to measure the resident memory.
+    /// @returns The memory usage of this arena at the time of the call.
+    arena_memory_usage
+    memory_usage(bool measure_resident = true) const {
+        arena_memory_usage result {
+            .reserved     = total_size_,
+            .committed    = total_size_,
+            .purged_pages = purged_pages_,
+            .purged_bytes = purged_pages_ * page_resource::page_size()
+        };
+
+    #if MALUNAL_ALLOCATORS_PLATFORM_POSIX
+        if (!measure_resident)
+            return result;
+
+        const auto page   = page_resource::page_size();
+        const auto length = k_max_alloc_size + sizeof(region);
+        std::vector<unsigned char> pages((length + page - 1) / page);
+        for (auto temp = first_; temp != nullptr; temp = temp->next) {
+            if (::mincore(temp, length, pages.data()) != 0)
+                continue;
+
+            for (const auto state : pages)
+                result.resident += (state & 1) != 0 ? page : 0;
+        }
+    #else /* Unsupported platform */
+        (void)measure_resident;
+    #endif /* Platform specific code */
+        return result;
+    }
+
+    /// @brief   Checks if the given pointer points into one of the regions
+    ///          acquired by this arena.
+    /// @details This walks the linked list of regions, so the cost grows with
+    ///          the number of regions acquired by this arena.
+    /// @param   ptr The pointer to check.
+    /// @returns True if the pointer is within one of the regions; false
+    ///          otherwise.
+    bool
+    owns(const void* ptr) const noexcept {
+        const auto address = reinterpret_cast<uintptr_t>(ptr);
+        for (auto temp = first_; temp != nullptr; temp = temp->next) {
+            const auto begin = reinterpret_cast<uintptr_t>(temp) + sizeof(region);
+            if (begin <= address && address < begin + k_max_alloc_size)
+                return true;
+        }
+
+        return false;
+    }
+
+    /// @brief   Walks every region of this arena from start to end, reporting
+    ///          each span of metadata, free and used memory in address order.
+    /// @details Free spans come straight from the free list, and everything in
+    ///          between them is reported as used, so adjacent allocations show
+    ///          up as a single used span. The free list is copied and sorted by
+    ///          address first, so this is meant for diagnostics rather than hot
+    ///          paths. The visitor must not allocate from this arena.
+    /// @param   visitor Called with each `arena_span` in turn.
+    template<typename Visitor>
+        requires std::invocable<Visitor&, const arena_span&>
+    void
+    walk(Visitor&& visitor) const {
+        std::vector<freed> blocks(free_list_.begin(), free_list_.end());
+        std::sort(blocks.begin(), blocks.end(), freed_addr_comparator());
+
+        size_t index = 0;
+        for (auto temp = first_; temp != nullptr; temp = temp->next, index++) {
+            const auto base  = reinterpret_cast<uintptr_t>(temp);
+            const auto end   = base + sizeof(region) + k_max_alloc_size;
+            auto       begin = base + sizeof(region);
+            if (temp == first_)
+                begin += k_free_list_size * sizeof(freed);
+            visitor(arena_span{ index, base, begin - base, arena_span_kind::metadata });
+
+            // Regions are not mapped in address order, so find where the free
+            // blocks of this region start.
+            auto block = std::lower_bound(
+                blocks.begin(),
+                blocks.end(),
+                freed{ .size = 0, .addr = begin },
+                freed_addr_comparator()
+            );
+
+            for (; block != blocks.end() && block->addr < end; block++) {
+                if (begin < block->addr)
+                    visitor(arena_span{ index, begin, block->addr - begin, arena_span_kind::used });
+                visitor(arena_span{ index, block->addr, block->size, arena_span_kind::free });
+                begin = block->addr + block->size;
+            }
+
+            if (begin < end)
+                visitor(arena_span{ index, begin, end - begin, arena_span_kind::used });
+        }
+    }
+
+    /// @brief   Releases every allocation made into this arena at once.
+    /// @details The regions acquired by this arena are kept, only the free list
+    ///          is rebuilt so that each region is entirely free again. Like the
+    ///          destructor, this will not call the destructors of any objects
+    ///          that were allocated into the regions.
+    /// @remarks Any pointer obtained from this arena before the reset is left
+    ///          dangling and must not be deallocated afterwards.
+    void
+    reset() {
+        free_list_.clear();
+        total_used_  = total_regions_ * sizeof(region);
+        total_used_ += k_free_list_size * sizeof(freed);
+        allocations_ = 0;
+        live_blocks_.fill(0);
+        vmem_fill_free_blocks();
+        hooks_.arena_reset();
+    }
+
+    /// @brief   Returns the whole pages of every free block to the operating
+    ///          system, while keeping them mapped.
+    /// @details The pages stay part of the regions of this arena and can be
+    ///          allocated again. Until then they no longer count towards the
+    ///          resident memory of the process. Only the pages entirely inside
+    ///          a free block are purged.
+    /// @remarks On POSIX platforms the operating system provides fresh zeroed
+    ///          pages once purged pages are touched again. On Windows they are
+    ///          reset with `MEM_RESET`, which leaves their contents undefined
+    ///          until they are written; either way, nothing allocated from the
+    ///          arena is zeroed.
+    /// @returns The number of bytes purged.
+    size_t
+    purge() noexcept {
+        const auto page  = page_resource::page_size();
+        size_t     total = 0;
+        for (const auto& block : free_list_) {
+            const auto begin = (block.addr + page - 1) & ~(page - 1);
+            const auto end   = (block.addr + block.size) & ~(page - 1);
+            if (end <= begin)
+                continue;
+
+            const auto ptr    = reinterpret_cast<void*>(begin);
+            const auto length = end - begin;
+        #if MALUNAL_ALLOCATORS_PLATFORM_WIN32
+            if (::VirtualAlloc(ptr, length, MEM_RESET, PAGE_READWRITE) == nullptr)
+                continue;
+        #elif MALUNAL_ALLOCATORS_PLATFORM_POSIX
+            if (::madvise(ptr, length, MADV_DONTNEED) != 0)
+                continue;
+        #else /* Unsupported platform */
+            (void)ptr;
+            continue;
+        #endif /* Platform specific code */
+            total += length;
+        }
+
+        purged_pages_ = total / page;
+        hooks_.purged(total);
+        return total;
+    }
+
 protected:
     /// @brief   Defines a region of virual memory that has been acquired from
     ///          the operating system.
@@ -266,9 +633,13 @@ protected:
     /// @param   bytes The number of bytes that need to be allocated.
     /// @param   alignment The alignment of the object to be allocated.
     /// @returns A pointer to the memory which the object can be placed into.
+    /// @throws  std::bad_alloc If no memory address could be obtained.
     void*
     do_allocate(size_t bytes, size_t alignment) override {
-        return vmem_allocate_region(bytes, alignment);
+        auto result = vmem_allocate_region(bytes, alignment);
+        if (result == nullptr)
+            detail::throw_bad_alloc();
+        return result;
     }
 
     /// @brief   Creates a free block from the pointer that was allocated.
@@ -301,14 +672,35 @@ protected:
     }
 
 private:
+    /// @brief The free list starts out in the space reserved for it in the first
+    ///        region, and moves to pages of its own once it outgrows that space.
+    using free_list_resource = fallback_resource<
+        linear_buffer_resource,
+        page_resource
+    >;
+
+    /// @brief   The size of the record of the alignment padding kept right in
+    ///          front of the blocks aligned past it.
+    inline static constexpr size_t
+    k_padding_record = sizeof(size_t);
+
     linear_buffer_resource  linbufres_;
+    free_list_resource      listres_;
     std::pmr::vector<freed> free_list_;
 
+    [[no_unique_address]]
+    detail::arena_hooks hooks_{};
+
     region* first_{nullptr};
     size_t  total_used_{0};
     size_t  total_size_{0};
     size_t  total_regions_{0};
     size_t  allocations_{0};
+    size_t  peak_used_{0};
+    size_t  region_growths_{0};
+    size_t  purged_pages_{0};
+
+    arena_stats::histogram live_blocks_{};
 
 
     void
@@ -323,11 +715,20 @@ private:
         total_used_ += length;
 
         // Reserve the entirety of the linear buffer resource through the free
-        // list vector, and push the first free node into the list.
+        // list vector, and fill it with the free blocks.
         free_list_.reserve(k_free_list_size);
+        vmem_fill_free_blocks();
+    }
+
+    void
+    vmem_fill_free_blocks() {
+        // Push the first free node into the list, it starts after the free
+        // list stored at the beginning of the first region.
+        const auto begin  = reinterpret_cast<uintptr_t>(first_) + sizeof(region);
+        const auto length = k_free_list_size * sizeof(freed);
         free_list_.push_back(freed {
             .size = k_max_alloc_size - length,
-            .addr = reinterpret_cast<uintptr_t>(buffer) + length
+            .addr = begin + length
         });
         allocations_++;
 
@@ -359,24 +760,31 @@ private:
 
         auto temp = &first_;
         for (auto index = 0u; index < blocks; index++) {
-            vmem_acquire(temp, k_regsize);
+            if (!vmem_acquire(temp, k_regsize)) {
+                if (first_ != nullptr)
+                    vmem_release(&first_);
+                detail::throw_bad_alloc();
+            }
+
             temp = &(*temp)->next;
         }
 
         vmem_init_free_blocks();
         total_size_ = blocks * k_regsize;
+        peak_used_  = total_used_;
     }
 
     void
-    vmem_release(region** pp_region) {
+    vmem_release(region** pp_region) noexcept {
         assert(*pp_region != nullptr);
         if ((*pp_region)->next != nullptr)
             vmem_release(&(*pp_region)->next);
 
+        hooks_.region_released(*pp_region, k_max_alloc_size + sizeof(region));
     #if MALUNAL_ALLOCATORS_PLATFORM_WIN32
         ::VirtualFree(*pp_region, 0, MEM_RELEASE);
     #elif MALUNAL_ALLOCATORS_PLATFORM_POSIX
-        ::munmap(*pp_region, k_max_alloc_size);
+        ::munmap(*pp_region, k_max_alloc_size + sizeof(region));
     #endif /* Platform specific code */
 
         total_used_ = 0;
@@ -384,70 +792,66 @@ private:
         *pp_region  = nullptr;
     }
 
-    void
-    vmem_acquire(region** pp_region, size_t capacity) {
+    bool
+    vmem_acquire(region** pp_region, size_t capacity) noexcept {
     #if MALUNAL_ALLOCATORS_PLATFORM_WIN32
         constexpr int32_t k_memops = MEM_COMMIT | MEM_RESERVE;
         constexpr int32_t k_pageops = PAGE_READWRITE;
         auto ptr = ::VirtualAlloc(0, capacity, k_memops, k_pageops);
+        if (ptr == nullptr)
+            return false;
         *pp_region = reinterpret_cast<region*>(ptr);
-        if (*pp_region == nullptr)
-            std::bad_alloc();
     #elif MALUNAL_ALLOCATORS_PLATFORM_POSIX
         constexpr int32_t k_memops = PROT_READ | PROT_WRITE;
         constexpr int32_t k_memprms = MAP_PRIVATE | MAP_ANONYMOUS;
-        const auto min = std::invoke([&capacity] {
-            auto res = capacity / 16;
-            return res < 1 ? capacity : res;
-        });
 
-        void* ptr = nullptr;
-        while (capacity >= min) {
-            ptr = ::mmap(0, capacity, k_memops, k_memprms, -1, 0);
-            if (ptr != MAP_FAILED && ptr != nullptr)
-                break;
-            
-            // Unrecoverable.
-            if (errno != ENOMEM    &&
-                errno != EOVERFLOW &&
-                errno != EAGAIN)
-                    break;
-            
-            // Try smaller size.
-            capacity /= 2;
-        }
-
-        // Did we fail?
+        // Regions are always carved up as if they were the full capacity, so
+        // a smaller mapping can't be used in its place.
+        void* ptr = ::mmap(0, capacity, k_memops, k_memprms, -1, 0);
         if (ptr == MAP_FAILED || ptr == nullptr)
-            throw std::bad_alloc();
+            return false;
         *pp_region = reinterpret_cast<region*>(ptr);
     #else /* Unsupported platform */
-        throw std::bad_alloc();
+        (void)pp_region;
+        (void)capacity;
+        return false;
     #endif /* Platform specific code */
 
         constexpr std::size_t k_regsize = sizeof(region);
         total_used_ += k_regsize;
         total_regions_++;
         (*pp_region)->next = nullptr;
+        hooks_.region_acquired(*pp_region, capacity);
+        return true;
+    }
+
+    static constexpr bool
+    vmem_records_padding(size_t alignment) noexcept {
+        // The padding in front of a block aligned past the record always has
+        // room for it, anything less aligned has less than a record of padding.
+        return alignment > k_padding_record;
+    }
+
+    static size_t
+    vmem_calc_adjust(uintptr_t addr, size_t alignment) noexcept {
+        if (!vmem_records_padding(alignment))
+            return detail::calc_fwd_adjust(addr, alignment);
+
+        return detail::calc_fwd_adjust(addr + k_padding_record, alignment) + k_padding_record;
     }
 
     void*
-    vmem_find_free_block(size_t bytes, size_t alignment) {
+    vmem_find_free_block(size_t bytes, size_t alignment) noexcept {
         size_t to_allocate{bytes};
         size_t adjustment{0};
 
+        // The free list is sorted by size, so the first block that the
+        // allocation fits into, including its alignment, is the best fit.
         auto itr = free_list_.begin();
         while (itr != free_list_.end()) {
-            const auto adjustment = detail::calc_fwd_adjust(itr->addr, alignment);
-            to_allocate += adjustment;
-            if (itr->size == to_allocate)
-                break;
-
-            const auto next = itr + 1;
-            const auto fits_in_current = bytes < itr->size;
-            const auto next_is_the_end = next == free_list_.end();
-            const auto next_is_better  = !next_is_the_end && itr->size < next->size;
-            if (fits_in_current && next_is_better == false)
+            adjustment  = vmem_calc_adjust(itr->addr, alignment);
+            to_allocate = bytes + adjustment;
+            if (to_allocate <= itr->size)
                 break;
 
             itr++;
@@ -455,43 +859,78 @@ private:
 
         // Failed to find a free block to allocate into.
         if (itr == free_list_.end())
-            throw std::bad_alloc();
+            return nullptr;
+
+        // Padding too short for a record stays in the free list, which takes
+        // another entry unless the allocation uses up the rest of the block.
+        const auto records = vmem_records_padding(alignment);
+        if (!records && adjustment != 0 && itr->size > to_allocate) {
+            const auto index = itr - free_list_.begin();
+            if (!vmem_grow_free_list())
+                return nullptr;
+            itr = free_list_.begin() + index;
+        }
 
-        // Shrink this freed block by the number of bytes
-        // to allocate.
+        // Shrink this freed block by the number of bytes to allocate. Only
+        // this block got smaller, so it is rotated down to its sorted position
+        // instead of sorting the whole list again.
         auto result = itr->addr;
         if (itr->size > to_allocate) {
             itr->size -= to_allocate;
             itr->addr  = itr->addr + to_allocate;
-            std::sort(
+            auto pos = std::upper_bound(
                 free_list_.begin(),
-                free_list_.end(),
+                itr,
+                *itr,
                 freed_size_comparator()
             );
+            std::rotate(pos, itr, itr + 1);
         } else free_list_.erase(itr);
 
-        total_used_ += to_allocate;
+        // The padding is either recorded right in front of the block, so that
+        // it is given back along with the block, or a few bytes which become a
+        // free block of their own and merge back once the block is freed.
+        const auto pointer = result + adjustment;
+        if (records) {
+            *reinterpret_cast<size_t*>(pointer - k_padding_record) = adjustment;
+            total_used_ += to_allocate;
+        } else {
+            if (adjustment != 0)
+                vmem_insert_free_block(freed { .size = adjustment, .addr = result });
+            total_used_ += bytes;
+        }
+
+        peak_used_ = std::max(peak_used_, total_used_);
         ++allocations_;
+        ++live_blocks_[arena_stats::size_class(bytes)];
 
-        return reinterpret_cast<void*>(result + adjustment);
+        hooks_.allocated(reinterpret_cast<void*>(pointer), bytes, alignment);
+        return reinterpret_cast<void*>(pointer);
     }
 
     void*
-    vmem_allocate_region(size_t bytes, size_t alignment) {
+    vmem_allocate_region(size_t bytes, size_t alignment) noexcept {
         // Try to find free block first.
         auto res = vmem_find_free_block(bytes, alignment);
         if (res != nullptr)
             return res;
 
+        // A new region can't fit the allocation either, or the free list can't
+        // grow to track the new region.
+        if (bytes > k_max_alloc_size || !vmem_grow_free_list())
+            return nullptr;
+
         // The region allocation size.
         const auto size = k_max_alloc_size + sizeof(region);
-        
+
         // Allocate new region.
         auto last = &first_;
         while (*last != nullptr)
             last = &(*last)->next;
-        vmem_acquire(last, size);
+        if (!vmem_acquire(last, size))
+            return nullptr;
         total_size_ += size;
+        region_growths_++;
 
         // Add new block to free list.
         const auto addr = reinterpret_cast<uintptr_t>(*last);
@@ -500,73 +939,160 @@ private:
             .addr = addr + sizeof(region)
         });
 
-        return vmem_find_free_block(bytes, alignment); 
+        return vmem_find_free_block(bytes, alignment);
+    }
+
+    bool
+    vmem_grow_free_list() noexcept {
+        if (free_list_.size() < free_list_.capacity())
+            return true;
+
+    #if MALUNAL_ALLOCATORS_EXCEPTIONS
+        try {
+            free_list_.reserve(free_list_.capacity() * 2);
+        } catch (const std::bad_alloc&) {
+            return false;
+        }
+    #else
+        free_list_.reserve(free_list_.capacity() * 2);
+    #endif /* MALUNAL_ALLOCATORS_EXCEPTIONS */
+        return true;
+    }
+
+    void
+    vmem_insert_free_block(const freed& block) {
+        free_list_.insert(
+            std::upper_bound(
+                free_list_.begin(),
+                free_list_.end(),
+                block,
+                freed_size_comparator()
+            ),
+            block
+        );
     }
 
     void
     vmem_deallocate_region(void* ptr, size_t bytes, size_t alignment) {
-        const auto pointer    = reinterpret_cast<uintptr_t>(ptr);
-        const auto adjustment = detail::calc_fwd_adjust(pointer, alignment);
-
-        bytes += adjustment;
-        const auto block_start = pointer - adjustment;
-        const auto block_end   = block_start + bytes;
-
-        // Iterate through each node and merge possibles.
-        auto index = 0u;
-        while (index != free_list_.size()) {
-            const auto curr = free_list_[index];
-            if (block_end <= curr.addr)
-                break;
-            index++;
+        hooks_.deallocated(ptr, bytes, alignment);
+        --live_blocks_[arena_stats::size_class(bytes)];
+
+        // Recorded padding is given back along with the block, any other
+        // padding was left in the free list when the block was allocated.
+        auto block = freed {
+            .size = bytes,
+            .addr = reinterpret_cast<uintptr_t>(ptr)
+        };
+        if (vmem_records_padding(alignment)) {
+            const auto adjustment = *reinterpret_cast<const size_t*>(block.addr - k_padding_record);
+            block.addr -= adjustment;
+            block.size += adjustment;
         }
 
-        // There were no free blocks that start after the one we're freeing.
-        // Add it to the beginning of the list.
-        if (index == 0) {
-            free_list_.insert(free_list_.begin(), freed {
-                .size = bytes,
-                .addr = block_start
-            });
-        } else {
-            // The block that starts after the one we're freeing has a block before
-            // it on the free list, and it ends right on the boundary starting our
-            // block. These blocks can be merged.
-            auto prev = free_list_.begin() + (index - 1);
-            if (prev->addr + prev->size == block_start) {
-                prev->size += bytes;
-                goto MERGE_BLOCKS;
-            }
+        --allocations_;
+        total_used_ -= block.size;
+
+        // The free list is sorted by size, so the free blocks right before and
+        // right after the freed one have to be searched for by address.
+        auto prev = free_list_.end();
+        auto next = free_list_.end();
+        for (auto itr = free_list_.begin(); itr != free_list_.end(); itr++) {
+            if (itr->addr + itr->size == block.addr)
+                prev = itr;
+            else if (itr->addr == block.addr + block.size)
+                next = itr;
+            if (prev != free_list_.end() && next != free_list_.end())
+                break;
+        }
 
-            // Insert block between previous and current.
-            auto curr = free_list_.begin() + index;
-            free_list_.insert(curr, freed {
-                .size = bytes,
-                .addr = block_start
-            });
+        // Merge the neighbours into the freed block and take them off the list,
+        // the one further down first so the other one stays where it is.
+        if (prev != free_list_.end()) {
+            block.addr  = prev->addr;
+            block.size += prev->size;
+        }
+        if (next != free_list_.end())
+            block.size += next->size;
+
+        if (prev != free_list_.end() && next != free_list_.end()) {
+            free_list_.erase(std::max(prev, next));
+            free_list_.erase(std::min(prev, next));
+        } else if (prev != free_list_.end()) {
+            free_list_.erase(prev);
+        } else if (next != free_list_.end()) {
+            free_list_.erase(next);
         }
 
-    MERGE_BLOCKS:
-        if (1 < free_list_.size()) {
-            auto curr = free_list_.begin() + index;
-            auto next = free_list_.begin() + index + 1;
-            if (curr->addr + curr->size == next->addr) {
-                curr->size += next->size;
-                free_list_.erase(next);
-            }
+        // Only the merged block is out of place, so it is inserted where it
+        // belongs instead of sorting the whole list again.
+        vmem_insert_free_block(block);
+    }
+};
 
-            // Sort by size again.
-            std::sort(
-                free_list_.begin(),
-                free_list_.end(),
-                freed_size_comparator()
+
+/// @brief   Writes a JSON occupancy map of the given arena memory resource.
+/// @details The map lists every region of the arena with its used and free
+///          byte counts and the spans reported by `walk()`, in address order:
+///
+///              { "regions": [ { "index": 0, "addr": "0x7f...", "size": 4194304,
+///                  "used": 1024, "free": 4193024, "spans": [
+///                    { "kind": "metadata", "addr": "0x7f...", "size": 520 }, ... ] } ] }
+///
+///          Whether an arena is bloated by fragmentation or by live data shows
+///          up as many small free spans between used spans, or as few of them.
+/// @param   arena The arena memory resource to map.
+/// @param   file The file to write the map to.
+/// @returns True if the map was written; false otherwise.
+inline bool
+write_occupancy_map(const arena_memory_resource& arena, std::FILE* file) {
+    if (file == nullptr)
+        return false;
+
+    constexpr const char* k_kinds[] = { "metadata", "free", "used" };
+    std::vector<arena_span> spans;
+    arena.walk([&spans](const arena_span& span) {
+        spans.push_back(span);
+    });
+
+    std::fprintf(file, "{\"regions\":[");
+    for (auto itr = spans.begin(); itr != spans.end();) {
+        // Every region starts with its metadata span.
+        const auto region = itr->region;
+        const auto last   = std::find_if(itr, spans.end(), [region](const arena_span& span) {
+            return span.region != region;
+        });
+
+        size_t used = 0;
+        size_t free = 0;
+        for (auto span = itr; span != last; span++)
+            (span->kind == arena_span_kind::free ? free : used) += span->size;
+
+        std::fprintf(file,
+            "%s{\"index\":%zu,\"addr\":\"%#zx\",\"size\":%zu,\"used\":%zu,\"free\":%zu,\"spans\":[",
+            region == 0 ? "" : ",",
+            region,
+            static_cast<size_t>(itr->addr),
+            used + free,
+            used,
+            free
+        );
+
+        for (auto span = itr; span != last; span++) {
+            std::fprintf(file, "%s{\"kind\":\"%s\",\"addr\":\"%#zx\",\"size\":%zu}",
+                span == itr ? "" : ",",
+                k_kinds[static_cast<size_t>(span->kind)],
+                static_cast<size_t>(span->addr),
+                span->size
             );
         }
 
-        --allocations_;
-        total_used_ -= bytes;
+        std::fprintf(file, "]}");
+        itr = last;
     }
-};
+
+    std::fprintf(file, "]}\n");
+    return std::ferror(file) == 0;
+}
 
 
 /// @brief   Provides a default arena memory resource.
@@ -581,4 +1107,19 @@ arena_allocator_instance() {
     return &k_arena_memory_resource;
 }
 
+/// @brief   Provides an arena memory resource owned by the calling thread.
+/// @details Each thread receives its own arena the first time it calls this
+///          function, which is released when that thread exits. Because the
+///          arena memory resource is not synchronized, this is the instance you
+///          want when allocations should never contend with other threads.
+/// @returns A pointer to the calling thread's arena memory resource.
+/// @remarks Memory obtained from this instance must be deallocated on the same
+///          thread, and must not outlive the thread that allocated it.
+inline arena_memory_resource*
+thread_arena_instance() {
+    thread_local arena_memory_resource
+    k_thread_arena_memory_resource;
+    return &k_thread_arena_memory_resource;
+}
+
 } // namespace malunal::allocators
@@ -4,14 +4,25 @@
 /// @copyright 2024 Malunal Studios, LLC.
 #pragma once
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
 #include <cassert>
+#include <chrono>
+#include <cmath>
 #include <concepts>
 #include <cstdint>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
 #include <functional>
 #include <memory>
 #include <memory_resource>
+#include <mutex>
+#include <source_location>
 #include <type_traits>
+#include <unordered_map>
+#include <vector>
 
 
 #if (defined(linux)     || \
@@ -29,6 +40,15 @@
 #endif /* Platform check */
 
 
+#if defined(__cpp_exceptions) || \
+    defined(__EXCEPTIONS)     || \
+    defined(_CPPUNWIND)
+#  define MALUNAL_ALLOCATORS_EXCEPTIONS 1
+#else
+#  define MALUNAL_ALLOCATORS_EXCEPTIONS 0
+#endif /* Exceptions check */
+
+
 namespace malunal::allocators::detail {
 
 /// @brief   Calculates the forward adjustment for a given pointer and the given
@@ -49,4 +69,17 @@ calc_fwd_adjust(uintptr_t ptr, size_t alignment) noexcept {
     return aligned - iptr;
 }
 
+/// @brief   Reports an allocation failure from an allocating function.
+/// @details Throws `std::bad_alloc` when exceptions are enabled. When the
+///          library is compiled with exceptions disabled there is no way to
+///          report the failure to the caller, so the program is aborted.
+[[noreturn]] inline void
+throw_bad_alloc() {
+#if MALUNAL_ALLOCATORS_EXCEPTIONS
+    throw std::bad_alloc();
+#else
+    std::abort();
+#endif /* MALUNAL_ALLOCATORS_EXCEPTIONS */
+}
+
 } // namespace malunal::allocators::detail
@@ -0,0 +1,317 @@
+/// @file   composite.hpp
+/// @brief  Provides memory resources composed from other memory resources.
+/// @author John Christman sorakatadzuma@gmail.com
+/// @copyright 2024 Malunal Studios, LLC.
+#pragma once
+
+
+namespace malunal::allocators {
+
+// Used as default template arguments, defined later on.
+struct arena_memory_resource;
+struct node_pool_resource;
+
+
+/// @brief   Describes a memory resource which can tell whether a pointer was
+///          allocated from it.
+/// @details Composed memory resources use the ownership check to route a
+///          deallocation back to the memory resource the pointer came from.
+template<typename Resource>
+concept owning_resource =
+    std::derived_from<Resource, std::pmr::memory_resource> &&
+    requires(const Resource& resource, const void* ptr) {
+        { resource.owns(ptr) } noexcept -> std::same_as<bool>;
+    };
+
+
+/// @brief   Describes a memory resource which can report an allocation failure
+///          by returning `nullptr` instead of throwing.
+template<typename Resource>
+concept nothrow_resource =
+    std::derived_from<Resource, std::pmr::memory_resource> &&
+    requires(Resource& resource, size_t bytes, size_t alignment) {
+        { resource.try_allocate(bytes, alignment) } noexcept -> std::same_as<void*>;
+    };
+
+
+namespace detail {
+
+/// @brief   Allocates from the given memory resource, returning `nullptr` if it
+///          could not provide the memory.
+/// @details Memory resources with a `try_allocate()` are called directly, so
+///          no exception is ever thrown. Any other memory resource has its
+///          `std::bad_alloc` caught, which is only possible with exceptions
+///          enabled; without them, the failure aborts the program.
+/// @param   resource The memory resource to allocate from.
+/// @param   bytes The amount of bytes to allocate.
+/// @param   alignment The alignment of the object to be allocated.
+/// @returns A pointer to where the data can be stored, or `nullptr`.
+template<typename Resource>
+void*
+try_allocate(Resource* resource, size_t bytes, size_t alignment) noexcept {
+    if constexpr (nothrow_resource<Resource>) {
+        return resource->try_allocate(bytes, alignment);
+    } else {
+    #if MALUNAL_ALLOCATORS_EXCEPTIONS
+        try {
+            return resource->allocate(bytes, alignment);
+        } catch (const std::bad_alloc&) {
+            return nullptr;
+        }
+    #else
+        return resource->allocate(bytes, alignment);
+    #endif /* MALUNAL_ALLOCATORS_EXCEPTIONS */
+    }
+}
+
+} // namespace detail
+
+
+/// @brief   A fallback resource is a memory resource which tries to allocate
+///          from a primary memory resource first, and from a fallback memory
+///          resource whenever the primary is unable to.
+/// @details The types of both memory resources are template parameters, so
+///          the routing between them is resolved at compile time. The primary
+///          memory resource must be able to tell whether it owns a pointer,
+///          which is how deallocations are routed; a linear buffer resource
+///          answers that with a single bounds check. When the primary memory
+///          resource provides `try_allocate()`, an exhausted primary is
+///          detected without throwing.
+/// @tparam  Primary The memory resource tried first.
+/// @tparam  Fallback The memory resource used when the primary is exhausted.
+template<
+    owning_resource Primary = linear_buffer_resource,
+    typename Fallback       = arena_memory_resource
+>
+    requires std::derived_from<Fallback, std::pmr::memory_resource>
+struct fallback_resource : std::pmr::memory_resource {
+    using super = std::pmr::memory_resource;
+    using self  = fallback_resource;
+
+    /// @brief   Constructs the fallback resource from the given primary and
+    ///          fallback memory resources.
+    /// @details Neither memory resource is owned by the fallback resource, they
+    ///          must outlive it.
+    /// @param   primary The memory resource tried first, must not be `nullptr`.
+    /// @param   fallback The memory resource used when the primary is
+    ///          exhausted, must not be `nullptr`.
+    fallback_resource(Primary* primary, Fallback* fallback) noexcept
+        : primary_{ primary }
+        , fallback_{ fallback }
+    {
+        assert(primary  != nullptr);
+        assert(fallback != nullptr);
+    }
+
+    /// @brief Provided for overriding classes to properly destruct themselves.
+    virtual
+    ~fallback_resource() noexcept = default;
+
+    /// @brief   Checks if the given pointer was allocated from either of the
+    ///          memory resources of this fallback resource.
+    /// @param   ptr The pointer to check.
+    /// @returns True if either memory resource owns the pointer.
+    bool
+    owns(const void* ptr) const noexcept requires owning_resource<Fallback> {
+        return primary_->owns(ptr) || fallback_->owns(ptr);
+    }
+
+    /// @brief   Allocates from the primary memory resource, or from the fallback
+    ///          memory resource, without throwing.
+    /// @param   bytes The amount of bytes to allocate.
+    /// @param   alignment The alignment of the object to be allocated.
+    /// @returns A pointer to where the data can be stored, or `nullptr` if
+    ///          neither memory resource could provide the memory.
+    void*
+    try_allocate(size_t bytes, size_t alignment) noexcept {
+        auto result = detail::try_allocate(primary_, bytes, alignment);
+        if (result != nullptr)
+            return result;
+        return detail::try_allocate(fallback_, bytes, alignment);
+    }
+
+    /// @brief   Provides the primary memory resource.
+    /// @returns A pointer to the primary memory resource.
+    Primary*
+    primary() const noexcept {
+        return primary_;
+    }
+
+    /// @brief   Provides the fallback memory resource.
+    /// @returns A pointer to the fallback memory resource.
+    Fallback*
+    fallback() const noexcept {
+        return fallback_;
+    }
+
+protected:
+    /// @brief   Allocates from the primary memory resource, or from the fallback
+    ///          memory resource if the primary could not provide the memory.
+    /// @param   bytes The amount of bytes to allocate.
+    /// @param   alignment The alignment of the object to be allocated.
+    /// @returns A pointer to where the data can be stored.
+    /// @throws  std::bad_alloc If neither memory resource could provide memory.
+    void*
+    do_allocate(size_t bytes, size_t alignment) override {
+        auto result = detail::try_allocate(primary_, bytes, alignment);
+        if (result != nullptr)
+            return result;
+        return fallback_->allocate(bytes, alignment);
+    }
+
+    /// @brief   Deallocates the given pointer from whichever memory resource
+    ///          owns it.
+    /// @param   ptr The pointer to the object to deallocate.
+    /// @param   bytes The size of the object to deallocate.
+    /// @param   alignment The alignment of the object to deallocate.
+    void
+    do_deallocate(void* ptr, size_t bytes, size_t alignment) override {
+        if (primary_->owns(ptr))
+            primary_->deallocate(ptr, bytes, alignment);
+        else fallback_->deallocate(ptr, bytes, alignment);
+    }
+
+    /// @brief   Checks if the memory resource provided is a fallback resource of
+    ///          the same type composing the same memory resources.
+    /// @param   other The other memory resource to compare to.
+    /// @returns True if the other memory resource composes the same primary and
+    ///          fallback memory resources; false otherwise.
+    bool
+    do_is_equal(const memory_resource& other) const noexcept override {
+        auto casted = dynamic_cast<const self*>(&other);
+        return casted    != nullptr           &&
+               primary_  == casted->primary_  &&
+               fallback_ == casted->fallback_;
+    }
+
+private:
+    Primary*  primary_{nullptr};
+    Fallback* fallback_{nullptr};
+};
+
+
+/// @brief   A segregator resource is a memory resource which routes every
+///          allocation to one of two memory resources by its size.
+/// @details Allocations of `Threshold` bytes or less go to the small memory
+///          resource, everything else goes to the large memory resource. The
+///          deallocation size is routed the same way, so the segregator never
+///          needs to ask either memory resource who owns a pointer.
+/// @tparam  Threshold The largest allocation routed to the small resource.
+/// @tparam  Small The memory resource for allocations up to the threshold.
+/// @tparam  Large The memory resource for allocations above the threshold.
+template<
+    size_t   Threshold,
+    typename Small = node_pool_resource,
+    typename Large = arena_memory_resource
+>
+    requires std::derived_from<Small, std::pmr::memory_resource> &&
+             std::derived_from<Large, std::pmr::memory_resource>
+struct segregator_resource : std::pmr::memory_resource {
+    using super = std::pmr::memory_resource;
+    using self  = segregator_resource;
+
+    /// @brief   The largest allocation routed to the small memory resource.
+    inline static constexpr size_t
+    k_threshold = Threshold;
+
+    /// @brief   Constructs the segregator resource from the given small and
+    ///          large memory resources.
+    /// @details Neither memory resource is owned by the segregator resource,
+    ///          they must outlive it.
+    /// @param   small The memory resource for small allocations, must not be
+    ///          `nullptr`.
+    /// @param   large The memory resource for large allocations, must not be
+    ///          `nullptr`.
+    segregator_resource(Small* small, Large* large) noexcept
+        : small_{ small }
+        , large_{ large }
+    {
+        assert(small != nullptr);
+        assert(large != nullptr);
+    }
+
+    /// @brief Provided for overriding classes to properly destruct themselves.
+    virtual
+    ~segregator_resource() noexcept = default;
+
+    /// @brief   Checks if the given pointer was allocated from either of the
+    ///          memory resources of this segregator resource.
+    /// @param   ptr The pointer to check.
+    /// @returns True if either memory resource owns the pointer.
+    bool
+    owns(const void* ptr) const noexcept
+        requires owning_resource<Small> && owning_resource<Large>
+    {
+        return small_->owns(ptr) || large_->owns(ptr);
+    }
+
+    /// @brief   Allocates from the memory resource matching the size, without
+    ///          throwing.
+    /// @param   bytes The amount of bytes to allocate.
+    /// @param   alignment The alignment of the object to be allocated.
+    /// @returns A pointer to where the data can be stored, or `nullptr` if the
+    ///          memory resource could not provide the memory.
+    void*
+    try_allocate(size_t bytes, size_t alignment) noexcept {
+        if (bytes <= k_threshold)
+            return detail::try_allocate(small_, bytes, alignment);
+        return detail::try_allocate(large_, bytes, alignment);
+    }
+
+    /// @brief   Provides the memory resource for small allocations.
+    /// @returns A pointer to the small memory resource.
+    Small*
+    small() const noexcept {
+        return small_;
+    }
+
+    /// @brief   Provides the memory resource for large allocations.
+    /// @returns A pointer to the large memory resource.
+    Large*
+    large() const noexcept {
+        return large_;
+    }
+
+protected:
+    /// @brief   Allocates from the memory resource matching the size.
+    /// @param   bytes The amount of bytes to allocate.
+    /// @param   alignment The alignment of the object to be allocated.
+    /// @returns A pointer to where the data can be stored.
+    /// @throws  std::bad_alloc If no memory address could be obtained.
+    void*
+    do_allocate(size_t bytes, size_t alignment) override {
+        if (bytes <= k_threshold)
+            return small_->allocate(bytes, alignment);
+        return large_->allocate(bytes, alignment);
+    }
+
+    /// @brief   Deallocates from the memory resource matching the size.
+    /// @param   ptr The pointer to the object to deallocate.
+    /// @param   bytes The size of the object to deallocate.
+    /// @param   alignment The alignment of the object to deallocate.
+    void
+    do_deallocate(void* ptr, size_t bytes, size_t alignment) override {
+        if (bytes <= k_threshold)
+            small_->deallocate(ptr, bytes, alignment);
+        else large_->deallocate(ptr, bytes, alignment);
+    }
+
+    /// @brief   Checks if the memory resource provided is a segregator resource
+    ///          of the same type composing the same memory resources.
+    /// @param   other The other memory resource to compare to.
+    /// @returns True if the other memory resource composes the same small and
+    ///          large memory resources; false otherwise.
+    bool
+    do_is_equal(const memory_resource& other) const noexcept override {
+        auto casted = dynamic_cast<const self*>(&other);
+        return casted != nullptr         &&
+               small_ == casted->small_  &&
+               large_ == casted->large_;
+    }
+
+private:
+    Small* small_{nullptr};
+    Large* large_{nullptr};
+};
+
+} // namespace malunal::allocators
@@ -0,0 +1,253 @@
+/// @file   coroutine.hpp
+/// @brief  Provides the coroutine frame allocator for promise types.
+/// @author John Christman sorakatadzuma@gmail.com
+/// @copyright 2024 Malunal Studios, LLC.
+#pragma once
+
+
+// Set coroutine frame cache size if not yet set.
+#ifndef MALUNAL_ALLOCATORS_COROUTINE_FRAME_CACHE_SIZE
+/// @def     MALUNAL_ALLOCATORS_COROUTINE_FRAME_CACHE_SIZE
+/// @brief   The number of coroutine frames cached per frame size per thread.
+/// @details This is modifiable by you the developer. It configures how many
+///          destroyed coroutine frames are kept around by each thread, for each
+///          promise type and frame size, so that the next coroutine with that
+///          body can reuse the frame without going back to the arena. The lower bounds is 0, which
+///          disables the cache, and the upper bounds is 65536.
+#define MALUNAL_ALLOCATORS_COROUTINE_FRAME_CACHE_SIZE 64
+#elif MALUNAL_ALLOCATORS_COROUTINE_FRAME_CACHE_SIZE < 0 || \
+      MALUNAL_ALLOCATORS_COROUTINE_FRAME_CACHE_SIZE > 65536
+#  error Coroutine frame cache size must be >= 0 and <= 65536
+#endif /* MALUNAL_ALLOCATORS_COROUTINE_FRAME_CACHE_SIZE */
+
+
+namespace malunal::allocators {
+
+/// @brief   The number of coroutine frames cached per frame size per thread.
+/// @details This is controlled by a macro which you, the developer, can
+///          adjust to your needs.
+inline static constexpr size_t
+k_frame_cache_size = MALUNAL_ALLOCATORS_COROUTINE_FRAME_CACHE_SIZE;
+
+/// @brief   The number of distinct frame sizes cached per promise type.
+/// @details Every coroutine body has its own frame size, so each promise type
+///          keeps this many bins per thread, one for each frame size it has
+///          seen. Frames of sizes beyond the bins go straight to the arena.
+inline static constexpr size_t
+k_frame_cache_bins = 8;
+
+/// @brief   The alignment that every coroutine frame is allocated with.
+/// @details Coroutine frames are allocated through the non-aligned allocation
+///          function, so they must satisfy the default new alignment.
+inline static constexpr size_t
+k_frame_alignment = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+
+namespace detail {
+
+/// @brief   Overlays a freed coroutine frame so frames can be linked.
+struct linked_frame final {
+    linked_frame* next;
+};
+
+/// @brief   The per thread owner of coroutine frames.
+/// @details Frames destroyed on a thread other than their owner are pushed
+///          onto the owner's remote list, and given back to the owner's arena
+///          the next time the owner allocates a frame. This is trivially
+///          destructible on purpose, the pending frames are reclaimed when the
+///          thread's arena is released.
+struct frame_owner final {
+    std::atomic<linked_frame*> remote;
+
+    /// @brief   Pushes a frame destroyed on another thread.
+    /// @param   frame The frame to give back to this owner.
+    void
+    push_remote(linked_frame* frame) noexcept {
+        auto head = remote.load(std::memory_order_relaxed);
+        do {
+            frame->next = head;
+        } while (!remote.compare_exchange_weak(
+            head, frame,
+            std::memory_order_release,
+            std::memory_order_relaxed));
+    }
+};
+
+/// @brief   Stored in front of every coroutine frame.
+/// @details Records the owning thread and the size of the allocation, so a
+///          frame destroyed on another thread can find its way back.
+struct frame_header final {
+    frame_owner* owner;
+    size_t       bytes;
+};
+
+/// @brief   The space reserved in front of every coroutine frame.
+inline static constexpr size_t
+k_frame_header_size = (sizeof(frame_header) + k_frame_alignment - 1) /
+                      k_frame_alignment * k_frame_alignment;
+
+/// @brief   Gets the frame owner of the calling thread.
+/// @returns The frame owner of the calling thread.
+inline frame_owner&
+this_frame_owner() noexcept {
+    thread_local frame_owner
+    k_frame_owner{nullptr};
+    return k_frame_owner;
+}
+
+/// @brief   Gets the header stored in front of a coroutine frame.
+/// @param   ptr The pointer to the coroutine frame.
+/// @returns The header of the coroutine frame.
+inline frame_header*
+header_of(void* ptr) noexcept {
+    return reinterpret_cast<frame_header*>(
+        static_cast<std::byte*>(ptr) - k_frame_header_size);
+}
+
+/// @brief   Gives frames destroyed on other threads back to the arena.
+/// @details Only ever called by the owning thread, the remote list is checked
+///          with a relaxed load first so the common case is a single load.
+/// @param   owner The frame owner of the calling thread.
+inline void
+drain_remote_frames(frame_owner& owner) noexcept {
+    if (owner.remote.load(std::memory_order_relaxed) == nullptr)
+        return;
+
+    auto frame = owner.remote.exchange(nullptr, std::memory_order_acquire);
+    while (frame != nullptr) {
+        auto next   = frame->next;
+        auto header = header_of(frame);
+        thread_arena_instance()->deallocate(
+            header, header->bytes, k_frame_alignment);
+        frame = next;
+    }
+}
+
+} // namespace detail
+
+
+/// @brief   A mixin for coroutine promise types which allocates the coroutine
+///          frames from the calling thread's arena memory resource.
+/// @details Derive your promise type from this mixin, passing the promise type
+///          itself as the template argument. The compiler will then use the
+///          allocation functions of this mixin for every coroutine frame with
+///          that promise type instead of the global `operator new`.
+///
+///          Every coroutine with the same body has the same frame size, so
+///          destroyed frames are cached per frame size, up to
+///          `k_frame_cache_bins` sizes and `k_frame_cache_size` frames each,
+///          and handed out again on the next allocation of that size without
+///          ever touching the arena.
+///
+///          Each frame records the thread which allocated it. A coroutine
+///          destroyed on another thread is handed back to that thread, which
+///          returns it to its own arena on its next frame allocation.
+/// @tparam  Promise The promise type deriving from this mixin.
+/// @remarks A coroutine may be resumed and destroyed on any thread, but it
+///          must not outlive the thread it was created on, since its frame
+///          lives in that thread's arena.
+template<typename Promise>
+struct coroutine_frame_allocator {
+    /// @brief   Allocates a coroutine frame of the given size.
+    /// @details Reuses a cached frame of the same size if there is one,
+    ///          otherwise the frame is allocated from the calling thread's
+    ///          arena memory resource. There is deliberately no overload taking
+    ///          the coroutine parameters, so the compiler falls back to this one
+    ///          for every coroutine.
+    /// @param   bytes The size of the coroutine frame.
+    /// @returns A pointer to where the coroutine frame can be stored.
+    /// @throws  std::bad_alloc If no memory address could be obtained.
+    static void*
+    operator new(size_t bytes) {
+        auto& owner = detail::this_frame_owner();
+        detail::drain_remote_frames(owner);
+
+        auto bin = find_bin(bytes);
+        if (bin != nullptr && bin->head != nullptr) {
+            auto result = bin->head;
+            bin->head   = result->next;
+            bin->count--;
+            return result;
+        }
+
+        const auto total  = bytes + detail::k_frame_header_size;
+        const auto header = static_cast<detail::frame_header*>(
+            thread_arena_instance()->allocate(total, k_frame_alignment));
+        header->owner = &owner;
+        header->bytes = total;
+        return reinterpret_cast<std::byte*>(header) +
+               detail::k_frame_header_size;
+    }
+
+    /// @brief   Deallocates a coroutine frame of the given size.
+    /// @details Frames owned by another thread are handed back to it. Frames
+    ///          owned by the calling thread are kept for reuse while the bin
+    ///          for their size has room, every other frame is returned to the
+    ///          calling thread's arena memory resource.
+    /// @param   ptr The pointer to the coroutine frame.
+    /// @param   bytes The size of the coroutine frame.
+    static void
+    operator delete(void* ptr, size_t bytes) noexcept {
+        const auto frame  = static_cast<detail::linked_frame*>(ptr);
+        const auto header = detail::header_of(ptr);
+        if (header->owner != &detail::this_frame_owner()) {
+            header->owner->push_remote(frame);
+            return;
+        }
+
+        auto bin = find_bin(bytes);
+        if (bin != nullptr && bin->count < k_frame_cache_size) {
+            frame->next = bin->head;
+            bin->head   = frame;
+            bin->count++;
+            return;
+        }
+
+        thread_arena_instance()->deallocate(
+            header, header->bytes, k_frame_alignment);
+    }
+
+private:
+    /// @brief The cached frames of a single frame size.
+    struct cache_bin final {
+        size_t                frame_size;
+        size_t                count;
+        detail::linked_frame* head;
+    };
+
+    /// @brief   The per thread cache of frames for this promise type.
+    /// @details This is trivially destructible on purpose, the cached frames
+    ///          are reclaimed when the thread's arena is released, so nothing
+    ///          needs to be done when the thread exits.
+    struct cache_state final {
+        cache_bin bins[k_frame_cache_bins];
+    };
+
+    static cache_state&
+    frame_cache() noexcept {
+        thread_local cache_state
+        k_cache_state{};
+        return k_cache_state;
+    }
+
+    /// @brief   Finds the bin for the given frame size, claiming a free bin if
+    ///          this size has not been seen on this thread yet.
+    /// @param   bytes The size of the coroutine frame.
+    /// @returns The bin for the frame size, or null if every bin is taken.
+    static cache_bin*
+    find_bin(size_t bytes) noexcept {
+        for (auto& bin : frame_cache().bins) {
+            if (bin.frame_size == bytes)
+                return &bin;
+
+            if (bin.frame_size == 0) {
+                bin.frame_size = bytes;
+                return &bin;
+            }
+        }
+
+        return nullptr;
+    }
+};
+
+} // namespace malunal::allocators
@@ -0,0 +1,133 @@
+/// @file   hooks.hpp
+/// @brief  Provides the allocation event hooks for the arena memory resource.
+/// @author John Christman sorakatadzuma@gmail.com
+/// @copyright 2024 Malunal Studios, LLC.
+#pragma once
+
+
+// Disable allocation hooks if not yet set.
+#ifndef MALUNAL_ALLOCATORS_ENABLE_HOOKS
+/// @def     MALUNAL_ALLOCATORS_ENABLE_HOOKS
+/// @brief   Enables the allocation event hooks of the arena memory resource.
+/// @details This is modifiable by you the developer. When set to 1, the arena
+///          memory resource stores a set of `allocation_hooks` which it calls
+///          on every allocation, deallocation, region acquisition and region
+///          release, as well as on every reset and purge. When set to 0, the
+///          default, the hooks are compiled out entirely and take up no space
+///          in the arena.
+/// @remarks The arena memory resource changes layout with this setting, so it
+///          must be the same for every translation unit of a program.
+#define MALUNAL_ALLOCATORS_ENABLE_HOOKS 0
+#endif /* MALUNAL_ALLOCATORS_ENABLE_HOOKS */
+
+
+namespace malunal::allocators {
+
+/// @brief   Whether the allocation event hooks are compiled in.
+/// @details This is controlled by a macro which you, the developer, can
+///          adjust to your needs.
+inline static constexpr bool
+k_hooks_enabled = MALUNAL_ALLOCATORS_ENABLE_HOOKS != 0;
+
+
+/// @brief   A set of callbacks invoked by the arena memory resource whenever it
+///          allocates, deallocates, acquires, releases, resets or purges memory.
+/// @details Every callback is optional and receives the `context` pointer as
+///          its first argument, which is where you would attach a tracer, a
+///          metrics sink or a leak checker. The callbacks are plain function
+///          pointers and are called synchronously from within the arena, so
+///          they must not allocate from, or deallocate into, the same arena.
+struct allocation_hooks final {
+    using allocate_hook = void(*)(void* context, void* ptr, size_t bytes, size_t alignment);
+    using region_hook   = void(*)(void* context, void* region, size_t bytes);
+    using reset_hook    = void(*)(void* context);
+    using purge_hook    = void(*)(void* context, size_t bytes);
+
+    /// @brief The user data passed to each of the callbacks.
+    void* context{nullptr};
+
+    /// @brief Called after memory has been allocated.
+    allocate_hook on_allocate{nullptr};
+
+    /// @brief Called before memory is deallocated.
+    allocate_hook on_deallocate{nullptr};
+
+    /// @brief Called after a region has been acquired from the operating system.
+    region_hook on_region_acquire{nullptr};
+
+    /// @brief Called before a region is released to the operating system.
+    region_hook on_region_release{nullptr};
+
+    /// @brief Called after every allocation was released by a reset.
+    reset_hook on_reset{nullptr};
+
+    /// @brief Called after free pages were returned to the operating system.
+    purge_hook on_purge{nullptr};
+
+    /// @brief Notifies the allocate callback, if any.
+    void
+    allocated(void* ptr, size_t bytes, size_t alignment) const noexcept {
+        if (on_allocate != nullptr)
+            on_allocate(context, ptr, bytes, alignment);
+    }
+
+    /// @brief Notifies the deallocate callback, if any.
+    void
+    deallocated(void* ptr, size_t bytes, size_t alignment) const noexcept {
+        if (on_deallocate != nullptr)
+            on_deallocate(context, ptr, bytes, alignment);
+    }
+
+    /// @brief Notifies the region acquire callback, if any.
+    void
+    region_acquired(void* region, size_t bytes) const noexcept {
+        if (on_region_acquire != nullptr)
+            on_region_acquire(context, region, bytes);
+    }
+
+    /// @brief Notifies the region release callback, if any.
+    void
+    region_released(void* region, size_t bytes) const noexcept {
+        if (on_region_release != nullptr)
+            on_region_release(context, region, bytes);
+    }
+
+    /// @brief Notifies the reset callback, if any.
+    void
+    arena_reset() const noexcept {
+        if (on_reset != nullptr)
+            on_reset(context);
+    }
+
+    /// @brief Notifies the purge callback, if any.
+    void
+    purged(size_t bytes) const noexcept {
+        if (on_purge != nullptr)
+            on_purge(context, bytes);
+    }
+};
+
+
+namespace detail {
+
+/// @brief   Stands in for `allocation_hooks` when the hooks are compiled out.
+/// @details Every notification is an empty inline function, so the calls made
+///          by the arena memory resource disappear entirely.
+struct disabled_hooks final {
+    void allocated(void*, size_t, size_t) const noexcept { }
+    void deallocated(void*, size_t, size_t) const noexcept { }
+    void region_acquired(void*, size_t) const noexcept { }
+    void region_released(void*, size_t) const noexcept { }
+    void arena_reset() const noexcept { }
+    void purged(size_t) const noexcept { }
+};
+
+/// @brief   The hook storage used by the arena memory resource.
+using arena_hooks = std::conditional_t<
+    k_hooks_enabled,
+    allocation_hooks,
+    disabled_hooks
+>;
+
+} // namespace detail
+} // namespace malunal::allocators
@@ -0,0 +1,307 @@
+/// @file   latency.hpp
+/// @brief  Provides the allocation latency histograms.
+/// @author John Christman sorakatadzuma@gmail.com
+/// @copyright 2024 Malunal Studios, LLC.
+#pragma once
+
+
+namespace malunal::allocators {
+
+/// @brief   A summary of the latencies recorded by a latency histogram, all
+///          in nanoseconds.
+/// @details Percentiles are reported as the upper bound of the bucket they
+///          fall into, so they are never lower than the true value and at most
+///          12.5% higher. The maximum is exact.
+struct latency_summary final {
+    /// @brief The number of latencies recorded.
+    size_t count{0};
+
+    /// @brief The mean latency.
+    double mean{0.0};
+
+    /// @brief The median latency.
+    uint64_t p50{0};
+
+    /// @brief The 99th percentile latency.
+    uint64_t p99{0};
+
+    /// @brief The 99.9th percentile latency.
+    uint64_t p999{0};
+
+    /// @brief The longest latency.
+    uint64_t max{0};
+};
+
+
+/// @brief   A lock-free log-linear histogram of latencies in nanoseconds.
+/// @details Every power of two is split into 8 linear buckets, so a bucket is
+///          never wider than an eighth of the values it holds, from a single
+///          nanosecond all the way up to the limit of 64 bits. Recording is a
+///          handful of relaxed atomic additions, so any number of threads can
+///          record into the same histogram while another reads it.
+struct latency_histogram {
+    using self = latency_histogram;
+
+    /// @brief The number of linear buckets per power of two.
+    inline static constexpr size_t
+    k_sub_buckets = 8;
+
+    /// @brief The total number of buckets.
+    inline static constexpr size_t
+    k_buckets = (64 - 2) * k_sub_buckets;
+
+    latency_histogram() noexcept = default;
+
+    latency_histogram(const latency_histogram& other) = delete;
+
+    latency_histogram&
+    operator=(const latency_histogram& other) = delete;
+
+    /// @brief   Records a single latency.
+    /// @param   nanoseconds The latency to record.
+    void
+    record(uint64_t nanoseconds) noexcept {
+        buckets_[bucket_index(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+        total_.fetch_add(nanoseconds, std::memory_order_relaxed);
+
+        auto current = max_.load(std::memory_order_relaxed);
+        while (current < nanoseconds &&
+               !max_.compare_exchange_weak(current, nanoseconds, std::memory_order_relaxed));
+    }
+
+    /// @brief   Provides the number of latencies recorded.
+    /// @returns The number of latencies.
+    size_t
+    count() const noexcept {
+        return count_.load(std::memory_order_relaxed);
+    }
+
+    /// @brief   Provides the latency below which the given fraction of the
+    ///          recorded latencies fall.
+    /// @param   fraction The fraction of latencies, between 0 and 1.
+    /// @returns The upper bound of the bucket holding that latency, or 0 if
+    ///          nothing was recorded.
+    uint64_t
+    percentile(double fraction) const noexcept {
+        const auto total = count();
+        if (total == 0)
+            return 0;
+
+        const auto rank = std::max<size_t>(
+            static_cast<size_t>(std::ceil(fraction * static_cast<double>(total))),
+            1
+        );
+
+        size_t seen = 0;
+        for (size_t index = 0; index < k_buckets; index++) {
+            seen += buckets_[index].load(std::memory_order_relaxed);
+            if (seen >= rank)
+                return std::min(bucket_upper(index), max());
+        }
+
+        return max();
+    }
+
+    /// @brief   Provides the longest latency recorded.
+    /// @returns The longest latency, or 0 if nothing was recorded.
+    uint64_t
+    max() const noexcept {
+        return max_.load(std::memory_order_relaxed);
+    }
+
+    /// @brief   Provides a summary of the latencies recorded so far.
+    /// @returns The count, mean, percentiles and maximum of the latencies.
+    latency_summary
+    summary() const noexcept {
+        const auto total = count();
+        return latency_summary {
+            .count = total,
+            .mean  = total == 0 ? 0.0 :
+                static_cast<double>(total_.load(std::memory_order_relaxed)) /
+                static_cast<double>(total),
+            .p50   = percentile(0.50),
+            .p99   = percentile(0.99),
+            .p999  = percentile(0.999),
+            .max   = max()
+        };
+    }
+
+    /// @brief   Forgets every latency recorded so far.
+    /// @details Latencies recorded concurrently with the reset may be lost.
+    void
+    reset() noexcept {
+        for (auto& bucket : buckets_)
+            bucket.store(0, std::memory_order_relaxed);
+        count_.store(0, std::memory_order_relaxed);
+        total_.store(0, std::memory_order_relaxed);
+        max_.store(0, std::memory_order_relaxed);
+    }
+
+    /// @brief   Provides the bucket a latency is recorded in.
+    /// @param   nanoseconds The latency.
+    /// @returns The index of the bucket.
+    static constexpr size_t
+    bucket_index(uint64_t nanoseconds) noexcept {
+        if (nanoseconds < k_sub_buckets)
+            return static_cast<size_t>(nanoseconds);
+
+        // The top bit picks the power of two, the next three bits pick the
+        // linear bucket within it.
+        const auto exponent = static_cast<size_t>(std::bit_width(nanoseconds)) - 1;
+        const auto linear   = static_cast<size_t>(nanoseconds >> (exponent - 3)) & (k_sub_buckets - 1);
+        return (exponent - 2) * k_sub_buckets + linear;
+    }
+
+    /// @brief   Provides the largest latency recorded in a bucket.
+    /// @param   index The index of the bucket.
+    /// @returns The upper bound of the bucket.
+    static constexpr uint64_t
+    bucket_upper(size_t index) noexcept {
+        if (index < k_sub_buckets)
+            return index;
+
+        const auto exponent = index / k_sub_buckets + 2;
+        const auto linear   = index % k_sub_buckets;
+        const auto lower    = static_cast<uint64_t>(k_sub_buckets + linear) << (exponent - 3);
+        return lower + (uint64_t{1} << (exponent - 3)) - 1;
+    }
+
+private:
+    std::array<std::atomic<uint64_t>, k_buckets> buckets_{};
+    std::atomic<size_t>   count_{0};
+    std::atomic<uint64_t> total_{0};
+    std::atomic<uint64_t> max_{0};
+};
+
+
+/// @brief   The allocation and deallocation latencies of a timed resource.
+struct latency_stats final {
+    /// @brief The latencies of the allocations.
+    latency_summary allocate;
+
+    /// @brief The latencies of the deallocations.
+    latency_summary deallocate;
+};
+
+
+/// @brief   A timed resource is a memory resource adapter which forwards every
+///          allocation to an upstream memory resource, and records how long
+///          each allocation and deallocation took.
+/// @details Each operation is timed with the steady clock, which on Linux is a
+///          `clock_gettime` served from the vDSO, and recorded into one latency
+///          histogram per operation. This is where the tail latencies of a
+///          memory resource show up, like the arena searching a long free list
+///          or mapping a new region.
+struct timed_resource : std::pmr::memory_resource {
+    using upstream = std::pmr::memory_resource;
+    using super    = std::pmr::memory_resource;
+    using self     = timed_resource;
+
+    /// @brief   Constructs the timed resource on top of the given upstream
+    ///          memory resource.
+    /// @param   upstream The memory resource to forward the allocations to,
+    ///          must not be `nullptr`.
+    explicit
+    timed_resource(upstream* upstream) noexcept
+        : upstream_{ upstream }
+    {
+        assert(upstream != nullptr);
+    }
+
+    timed_resource(const timed_resource& other) = delete;
+
+    timed_resource&
+    operator=(const timed_resource& other) = delete;
+
+    /// @brief   Provides the latency histogram of the allocations.
+    /// @returns A reference to the allocation latency histogram.
+    const latency_histogram&
+    allocate_latency() const noexcept {
+        return allocate_;
+    }
+
+    /// @brief   Provides the latency histogram of the deallocations.
+    /// @returns A reference to the deallocation latency histogram.
+    const latency_histogram&
+    deallocate_latency() const noexcept {
+        return deallocate_;
+    }
+
+    /// @brief   Provides a summary of the latencies of both operations.
+    /// @returns The allocation and deallocation latency summaries.
+    latency_stats
+    stats() const noexcept {
+        return latency_stats {
+            .allocate   = allocate_.summary(),
+            .deallocate = deallocate_.summary()
+        };
+    }
+
+    /// @brief   Forgets every latency recorded so far.
+    void
+    reset_stats() noexcept {
+        allocate_.reset();
+        deallocate_.reset();
+    }
+
+    /// @brief   Provides the upstream memory resource of this timed resource.
+    /// @returns A pointer to the upstream memory resource.
+    upstream*
+    upstream_resource() const noexcept {
+        return upstream_;
+    }
+
+protected:
+    /// @brief   Allocates from the upstream memory resource and records how long
+    ///          it took.
+    /// @param   bytes The amount of bytes to allocate.
+    /// @param   alignment The alignment of the object to be allocated.
+    /// @returns A pointer to where the data can be stored.
+    /// @throws  std::bad_alloc If no memory address could be obtained.
+    void*
+    do_allocate(size_t bytes, size_t alignment) override {
+        const auto start  = clock::now();
+        auto       result = upstream_->allocate(bytes, alignment);
+        allocate_.record(elapsed(start));
+        return result;
+    }
+
+    /// @brief   Deallocates from the upstream memory resource and records how
+    ///          long it took.
+    /// @param   ptr The pointer to the object to deallocate.
+    /// @param   bytes The size of the object to deallocate.
+    /// @param   alignment The alignment of the object to deallocate.
+    void
+    do_deallocate(void* ptr, size_t bytes, size_t alignment) override {
+        const auto start = clock::now();
+        upstream_->deallocate(ptr, bytes, alignment);
+        deallocate_.record(elapsed(start));
+    }
+
+    /// @brief   Checks if the memory resource provided is this timed resource.
+    /// @param   other The other memory resource to compare to.
+    /// @returns True if the other memory resource is this timed resource.
+    bool
+    do_is_equal(const memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+private:
+    using clock = std::chrono::steady_clock;
+
+    upstream*         upstream_{nullptr};
+    latency_histogram allocate_;
+    latency_histogram deallocate_;
+
+
+    static uint64_t
+    elapsed(clock::time_point start) noexcept {
+        const auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            clock::now() - start
+        );
+        return static_cast<uint64_t>(duration.count());
+    }
+};
+
+} // namespace malunal::allocators
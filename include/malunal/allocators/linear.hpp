@@ -7,13 +7,29 @@
 
 namespace malunal::allocators {
 
+/// @brief   Describes how a linear buffer resource handles deallocations.
+enum class linear_mode : uint8_t {
+    /// @brief Deallocations are ignored, memory is only reclaimed by a reset.
+    monotonic,
+
+    /// @brief Deallocating the most recent allocation moves the pointer back to
+    ///        where that allocation started, giving stack semantics. Blocks
+    ///        freed directly below the most recent allocation are remembered
+    ///        and reclaimed together with it, so a growing vector gives back
+    ///        both its old and new buffers.
+    lifo
+};
+
+
 /// @brief   A linear buffer resource is a memory resource that linearly
 ///          allocates a provided buffer, pushing a pointer forward everytime
 ///          an allocation is performed.
 /// @details This is one of the simplest types of memory resources provided by
 ///          this library. It's very useful for when you just need to allocate
 ///          and not deallocate. Deallocation of this buffer resource is done
-///          simply by calling the `reset()` or `clear()` methods.
+///          simply by calling the `reset()` or `clear()` methods, unless it was
+///          constructed with `linear_mode::lifo`, in which case freeing the
+///          most recent allocation also returns its memory.
 struct linear_buffer_resource : std::pmr::memory_resource {
     using super = std::pmr::memory_resource;
     using self  = linear_buffer_resource;
@@ -66,12 +82,16 @@ struct linear_buffer_resource : std::pmr::memory_resource {
     ///          allocate data into.
     /// @param   length The length of the buffer provided to this linear buffer
     ///          resource.
+    /// @param   mode How deallocations are handled by this linear buffer
+    ///          resource.
     linear_buffer_resource(
-        void*  buffer,
-        size_t length
+        void*       buffer,
+        size_t      length,
+        linear_mode mode = linear_mode::monotonic
     ) noexcept
         : buffer_{ buffer }
         , length_{ length }
+        , mode_{ mode }
     {
         assert(buffer != nullptr);
         assert(length != 0);
@@ -84,7 +104,9 @@ struct linear_buffer_resource : std::pmr::memory_resource {
     ///          you should call the `clear()` method.
     void
     reset() noexcept {
-        count_ = 0;
+        count_       = 0;
+        freed_begin_ = 0;
+        freed_end_   = 0;
     }
 
     /// @brief   Clears the linear buffer resource underlying buffer and resets
@@ -98,44 +120,112 @@ struct linear_buffer_resource : std::pmr::memory_resource {
         reset();
     }
 
-protected:
+    /// @brief   Provides how this linear buffer resource handles deallocations.
+    /// @returns The deallocation mode of this linear buffer resource.
+    linear_mode
+    mode() const noexcept {
+        return mode_;
+    }
+
     /// @brief   Allocates a piece of the buffer by the given size in bytes and
-    ///          aligned to the provided alignment.
+    ///          aligned to the provided alignment, without throwing.
+    /// @details This is the allocation path used by `do_allocate()`, exposed so
+    ///          hot paths and composed memory resources can detect a full buffer
+    ///          without paying for exception unwinding.
     /// @param   bytes The amount of bytes to allocate.
     /// @param   alignment The alignment for determining the byte boundary of
     ///          where the resulting pointer should start.
-    /// @returns A pointer to where the data can be stored.
-    /// @throws  std::bad_alloc If no memory address could be obtained.
+    /// @returns A pointer to where the data can be stored, or `nullptr` if the
+    ///          buffer does not have enough space left.
     void*
-    do_allocate(size_t bytes, size_t alignment) override {
+    try_allocate(size_t bytes, size_t alignment) noexcept {
         assert(buffer_ != nullptr);
         assert(length_ != 0);
         if (bytes == 0 || alignment == 0)
-            throw std::bad_alloc();
+            return nullptr;
 
         const auto address    = reinterpret_cast<uintptr_t>(buffer_);
         const auto adjustment = detail::calc_fwd_adjust(address + count_, alignment);
         const auto old_count  = count_ + adjustment;
-        const auto new_count  = count_ + bytes;
+        const auto new_count  = old_count + bytes;
         if (new_count > length_)
-            throw std::bad_alloc();
-        
+            return nullptr;
+
         count_ = new_count;
         return reinterpret_cast<void*>(address + old_count);
     }
 
+    /// @brief   Checks if the given pointer points into the buffer of this
+    ///          linear buffer resource.
+    /// @details This only compares the pointer against the bounds of the buffer
+    ///          so it is a constant time check, which makes the linear buffer
+    ///          resource a good primary resource for composition.
+    /// @param   ptr The pointer to check.
+    /// @returns True if the pointer is within the buffer; false otherwise.
+    bool
+    owns(const void* ptr) const noexcept {
+        const auto address = reinterpret_cast<uintptr_t>(ptr);
+        const auto begin   = reinterpret_cast<uintptr_t>(buffer_);
+        return begin <= address && address < begin + length_;
+    }
+
+protected:
+    /// @brief   Allocates a piece of the buffer by the given size in bytes and
+    ///          aligned to the provided alignment.
+    /// @param   bytes The amount of bytes to allocate.
+    /// @param   alignment The alignment for determining the byte boundary of
+    ///          where the resulting pointer should start.
+    /// @returns A pointer to where the data can be stored.
+    /// @throws  std::bad_alloc If no memory address could be obtained.
+    void*
+    do_allocate(size_t bytes, size_t alignment) override {
+        auto result = try_allocate(bytes, alignment);
+        if (result == nullptr)
+            detail::throw_bad_alloc();
+        return result;
+    }
+
     /// @brief   Deallocates the given pointer from the linear buffer resource.
-    /// @details This method actually won't do anything because linear buffer
-    ///          resources do not actually deallocate anything unless requested
-    ///          to reset or clear.
+    /// @details In `linear_mode::monotonic` this method won't do anything
+    ///          because linear buffer resources do not deallocate anything
+    ///          unless requested to reset or clear. In `linear_mode::lifo`, if
+    ///          the pointer is the most recent allocation, the used count is
+    ///          moved back to where it started, and further back over the freed
+    ///          blocks that end right where it started. Any other pointer is
+    ///          remembered if it borders the freed blocks, or is above them,
+    ///          and ignored otherwise.
     /// @param   ptr The pointer to the object to deallocate.
     /// @param   bytes The number of bytes of the object being deallocated.
     /// @param   alignment The alignment of the object being deallocated.
     void
     do_deallocate(void* ptr, size_t bytes, size_t alignment) override {
-        (void)ptr;
-        (void)bytes;
         (void)alignment;
+        if (mode_ != linear_mode::lifo)
+            return;
+
+        const auto address = reinterpret_cast<uintptr_t>(buffer_);
+        const auto begin   = reinterpret_cast<uintptr_t>(ptr) - address;
+        const auto end     = begin + bytes;
+        if (end == count_) {
+            count_ = begin;
+            if (freed_begin_ != freed_end_ && freed_end_ == count_) {
+                count_       = freed_begin_;
+                freed_begin_ = 0;
+                freed_end_   = 0;
+            }
+            return;
+        }
+
+        // Only blocks that touch exactly can be merged, any padding between
+        // them might hold a small block which is still alive.
+        if (freed_begin_ == freed_end_ || begin > freed_end_) {
+            freed_begin_ = begin;
+            freed_end_   = end;
+        } else if (begin == freed_end_) {
+            freed_end_ = end;
+        } else if (end == freed_begin_) {
+            freed_begin_ = begin;
+        }
     }
 
     /// @brief   Checks if the memory resource provided is a linear buffer
@@ -181,9 +271,12 @@ protected:
     }
 
 private:
-    void*  buffer_{nullptr};
-    size_t length_{0};
-    size_t count_{0};
+    void*       buffer_{nullptr};
+    size_t      length_{0};
+    size_t      count_{0};
+    size_t      freed_begin_{0};
+    size_t      freed_end_{0};
+    linear_mode mode_{linear_mode::monotonic};
 };
 
 } // namespace malunal::allocators
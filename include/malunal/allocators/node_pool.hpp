@@ -0,0 +1,267 @@
+/// @file   node_pool.hpp
+/// @brief  Provides the node pool resource implementation.
+/// @author John Christman sorakatadzuma@gmail.com
+/// @copyright 2024 Malunal Studios, LLC.
+#pragma once
+
+
+// Set node pool maximum node size if not yet set.
+#ifndef MALUNAL_ALLOCATORS_NODE_POOL_MAXIMUM_SIZE
+/// @def     MALUNAL_ALLOCATORS_NODE_POOL_MAXIMUM_SIZE
+/// @brief   The largest allocation served from the node pool free lists.
+/// @details This is modifiable by you the developer. It configures the largest
+///          size in bytes that is considered a node. Anything larger is passed
+///          through to the upstream memory resource. The value must be a
+///          multiple of 8, the lower bounds is 16 and the upper bounds is 4096.
+#define MALUNAL_ALLOCATORS_NODE_POOL_MAXIMUM_SIZE 256
+#elif MALUNAL_ALLOCATORS_NODE_POOL_MAXIMUM_SIZE < 16   || \
+      MALUNAL_ALLOCATORS_NODE_POOL_MAXIMUM_SIZE > 4096 || \
+      MALUNAL_ALLOCATORS_NODE_POOL_MAXIMUM_SIZE % 8 != 0
+#  error Node pool maximum size must be a multiple of 8, >= 16 and <= 4096
+#endif /* MALUNAL_ALLOCATORS_NODE_POOL_MAXIMUM_SIZE */
+
+// Set node pool chunk size if not yet set.
+#ifndef MALUNAL_ALLOCATORS_NODE_POOL_CHUNK_SIZE
+/// @def     MALUNAL_ALLOCATORS_NODE_POOL_CHUNK_SIZE
+/// @brief   The number of nodes acquired at once when a free list runs dry.
+/// @details This is modifiable by you the developer. It configures how many
+///          nodes of a single size are carved out of each chunk acquired from
+///          the upstream memory resource. The lower bounds is 1 and the upper
+///          bounds is 4096, and a chunk of the largest nodes must fit within
+///          the maximum allocation size of the arena regions.
+#define MALUNAL_ALLOCATORS_NODE_POOL_CHUNK_SIZE 64
+#elif MALUNAL_ALLOCATORS_NODE_POOL_CHUNK_SIZE < 1    || \
+      MALUNAL_ALLOCATORS_NODE_POOL_CHUNK_SIZE > 4096 || \
+      MALUNAL_ALLOCATORS_NODE_POOL_CHUNK_SIZE * MALUNAL_ALLOCATORS_NODE_POOL_MAXIMUM_SIZE > MALUNAL_ALLOCATORS_REGION_MAXIMUM_ALLOCATION
+#  error Node pool chunk size must be >= 1, <= 4096 and fit the largest nodes within the maximum allocation size
+#endif /* MALUNAL_ALLOCATORS_NODE_POOL_CHUNK_SIZE */
+
+
+namespace malunal::allocators {
+
+/// @brief   The largest allocation served from the node pool free lists.
+/// @details This is controlled by a macro which you, the developer, can
+///          adjust to your needs.
+inline static constexpr size_t
+k_node_max_size = MALUNAL_ALLOCATORS_NODE_POOL_MAXIMUM_SIZE;
+
+/// @brief   The number of nodes carved out of each node pool chunk.
+/// @details This is controlled by a macro which you, the developer, can
+///          adjust to your needs.
+inline static constexpr size_t
+k_node_chunk_size = MALUNAL_ALLOCATORS_NODE_POOL_CHUNK_SIZE;
+
+
+/// @brief   A node pool resource is a memory resource which serves the small,
+///          fixed size allocations made by node based containers from intrusive
+///          free lists, one per node size.
+/// @details Containers like `std::pmr::list`, `std::pmr::map`, `std::pmr::set`
+///          and `std::pmr::unordered_map` allocate every element as a node of
+///          the same size. The node pool rounds each small allocation up to a
+///          size class of 8 bytes, and the first time a size class is seen it
+///          acquires a chunk of `k_node_chunk_size` nodes from the upstream
+///          memory resource. Freed nodes are pushed onto the free list of their
+///          size class, so allocation and deallocation never search anything.
+///
+///          Allocations larger than `k_node_max_size`, or with an alignment
+///          stricter than `std::max_align_t`, are passed through to the
+///          upstream memory resource.
+/// @remarks Chunks are only returned to the upstream memory resource when the
+///          node pool is released or destroyed.
+struct node_pool_resource : std::pmr::memory_resource {
+    using upstream = std::pmr::memory_resource;
+    using super    = std::pmr::memory_resource;
+    using self     = node_pool_resource;
+
+    /// @brief   Constructs the node pool resource on top of the given upstream
+    ///          memory resource.
+    /// @param   upstream The memory resource that chunks and oversized
+    ///          allocations are acquired from, must not be `nullptr`.
+    explicit
+    node_pool_resource(upstream* upstream = arena_allocator_instance()) noexcept
+        : upstream_{ upstream }
+    {
+        assert(upstream != nullptr);
+    }
+
+    node_pool_resource(const node_pool_resource& other) = delete;
+
+    node_pool_resource&
+    operator=(const node_pool_resource& other) = delete;
+
+    /// @brief   Releases all of the chunks back to the upstream memory resource.
+    /// @details No destructors are called for the nodes still in use.
+    virtual
+    ~node_pool_resource() noexcept {
+        release();
+    }
+
+    /// @brief   Returns every chunk acquired by this node pool to the upstream
+    ///          memory resource.
+    /// @details Every node handed out by this node pool is invalidated, and the
+    ///          free lists are emptied so that the next allocation of each size
+    ///          class acquires a new chunk.
+    void
+    release() noexcept {
+        while (chunks_ != nullptr) {
+            auto next = chunks_->next;
+            upstream_->deallocate(chunks_, chunks_->size, k_chunk_alignment);
+            chunks_ = next;
+        }
+
+        std::fill(std::begin(pools_), std::end(pools_), nullptr);
+        total_chunks_ = 0;
+    }
+
+    /// @brief   Checks if the given pointer is a node carved out of one of the
+    ///          chunks of this node pool.
+    /// @details This walks the list of chunks, so the cost grows with the number
+    ///          of chunks acquired. Allocations passed through to the upstream
+    ///          memory resource are not owned by the node pool.
+    /// @param   ptr The pointer to check.
+    /// @returns True if the pointer is within one of the chunks; false
+    ///          otherwise.
+    bool
+    owns(const void* ptr) const noexcept {
+        const auto address = reinterpret_cast<uintptr_t>(ptr);
+        for (auto temp = chunks_; temp != nullptr; temp = temp->next) {
+            const auto begin = reinterpret_cast<uintptr_t>(temp);
+            if (begin + k_chunk_header <= address && address < begin + temp->size)
+                return true;
+        }
+
+        return false;
+    }
+
+    /// @brief   Provides the upstream memory resource of this node pool.
+    /// @returns A pointer to the upstream memory resource.
+    upstream*
+    upstream_resource() const noexcept {
+        return upstream_;
+    }
+
+    /// @brief   Provides the number of chunks acquired from the upstream memory
+    ///          resource.
+    /// @details The node pool resource tracks this for diagnostic purposes.
+    /// @returns The number of chunks held by this node pool.
+    size_t
+    total_chunks() const noexcept {
+        return total_chunks_;
+    }
+
+protected:
+    /// @brief   Allocates a node of the given size from the free list of its
+    ///          size class, or from the upstream memory resource if the size is
+    ///          not a node size.
+    /// @param   bytes The amount of bytes to allocate.
+    /// @param   alignment The alignment of the object to be allocated.
+    /// @returns A pointer to where the data can be stored.
+    /// @throws  std::bad_alloc If no memory address could be obtained.
+    void*
+    do_allocate(size_t bytes, size_t alignment) override {
+        const auto size = size_class(bytes, alignment);
+        if (size == 0)
+            return upstream_->allocate(bytes, alignment);
+
+        auto& head = pools_[size / k_granularity - 1];
+        if (head == nullptr)
+            grow(head, size);
+
+        auto result = head;
+        head = result->next;
+        return result;
+    }
+
+    /// @brief   Pushes the given node back onto the free list of its size
+    ///          class, or returns it to the upstream memory resource if the
+    ///          size is not a node size.
+    /// @param   ptr The pointer to the node to deallocate.
+    /// @param   bytes The size of the node to deallocate.
+    /// @param   alignment The alignment of the node to deallocate.
+    void
+    do_deallocate(void* ptr, size_t bytes, size_t alignment) override {
+        const auto size = size_class(bytes, alignment);
+        if (size == 0) {
+            upstream_->deallocate(ptr, bytes, alignment);
+            return;
+        }
+
+        auto& head = pools_[size / k_granularity - 1];
+        auto  node = static_cast<free_node*>(ptr);
+        node->next = head;
+        head = node;
+    }
+
+    /// @brief   Checks if the memory resource provided is this node pool.
+    /// @details Node pools own their chunks, so a node can only be returned to
+    ///          the node pool that allocated it.
+    /// @param   other The other memory resource to compare to.
+    /// @returns True if the other memory resource is this node pool.
+    bool
+    do_is_equal(const memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+private:
+    /// @brief The granularity of the node size classes.
+    inline static constexpr size_t
+    k_granularity = 8;
+
+    /// @brief The alignment of every chunk, and the strictest node alignment.
+    inline static constexpr size_t
+    k_chunk_alignment = alignof(std::max_align_t);
+
+    /// @brief Overlays a free node so the free lists can link the nodes.
+    struct free_node final {
+        free_node* next;
+    };
+
+    /// @brief The header at the start of every chunk.
+    struct chunk final {
+        chunk* next;
+        size_t size;
+    };
+
+    /// @brief The offset of the first node in a chunk.
+    inline static constexpr size_t
+    k_chunk_header = (sizeof(chunk) + k_chunk_alignment - 1) & ~(k_chunk_alignment - 1);
+    static_assert(k_chunk_header + k_node_max_size * k_node_chunk_size <= k_max_alloc_size,
+        "A chunk of the largest nodes must fit within the maximum allocation size");
+
+    upstream*  upstream_{nullptr};
+    chunk*     chunks_{nullptr};
+    size_t     total_chunks_{0};
+    free_node* pools_[k_node_max_size / k_granularity]{};
+
+
+    static constexpr size_t
+    size_class(size_t bytes, size_t alignment) noexcept {
+        if (alignment > k_chunk_alignment)
+            return 0;
+
+        const auto step = std::max(alignment, k_granularity);
+        const auto size = (std::max(bytes, sizeof(free_node)) + step - 1) & ~(step - 1);
+        return size <= k_node_max_size ? size : 0;
+    }
+
+    void
+    grow(free_node*& head, size_t size) {
+        const auto bytes = k_chunk_header + size * k_node_chunk_size;
+        auto block = static_cast<chunk*>(upstream_->allocate(bytes, k_chunk_alignment));
+        block->next = chunks_;
+        block->size = bytes;
+        chunks_ = block;
+        total_chunks_++;
+
+        // Thread the nodes of the chunk onto the free list in address order, so
+        // consecutive allocations are laid out next to each other.
+        const auto begin = reinterpret_cast<uintptr_t>(block) + k_chunk_header;
+        for (auto index = k_node_chunk_size; index > 0; index--) {
+            auto node  = reinterpret_cast<free_node*>(begin + (index - 1) * size);
+            node->next = head;
+            head = node;
+        }
+    }
+};
+
+} // namespace malunal::allocators
@@ -0,0 +1,138 @@
+/// @file   page.hpp
+/// @brief  Provides the page resource implementation.
+/// @author John Christman sorakatadzuma@gmail.com
+/// @copyright 2024 Malunal Studios, LLC.
+#pragma once
+
+
+#if MALUNAL_ALLOCATORS_PLATFORM_POSIX
+#include <sys/mman.h>
+#include <unistd.h>
+#elif MALUNAL_ALLOCATORS_PLATFORM_WIN32
+#define WIN32_LEAN_AND_MEAN 1
+#define NOMINMAX 1
+#include <windows.h>
+#endif /* Platform specific headers */
+
+
+namespace malunal::allocators {
+
+/// @brief   A page resource is a memory resource which maps every allocation
+///          directly from the operating system, in whole pages.
+/// @details This is the memory resource of last resort, used for bookkeeping
+///          that must never go through `malloc` or `operator new`, like the
+///          free list of the arena memory resource once it outgrows the space
+///          reserved for it. Every allocation is rounded up to whole pages and
+///          every deallocation returns those pages to the operating system.
+struct page_resource : std::pmr::memory_resource {
+    using super = std::pmr::memory_resource;
+    using self  = page_resource;
+
+    /// @brief   Provides the size of a page of virtual memory.
+    /// @returns The page size of the operating system in bytes.
+    static size_t
+    page_size() noexcept {
+    #if MALUNAL_ALLOCATORS_PLATFORM_WIN32
+        static const size_t k_page_size = std::invoke([] {
+            SYSTEM_INFO info;
+            ::GetSystemInfo(&info);
+            return static_cast<size_t>(info.dwPageSize);
+        });
+    #elif MALUNAL_ALLOCATORS_PLATFORM_POSIX
+        static const size_t k_page_size = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    #else /* Unsupported platform */
+        static const size_t k_page_size = 4096;
+    #endif /* Platform specific code */
+        return k_page_size;
+    }
+
+    /// @brief   Maps the pages for the given number of bytes, without throwing.
+    /// @param   bytes The amount of bytes to allocate.
+    /// @param   alignment The alignment of the object to be allocated, must not
+    ///          be larger than a page.
+    /// @returns A pointer to the first page, or `nullptr` if the pages could
+    ///          not be mapped.
+    void*
+    try_allocate(size_t bytes, size_t alignment) noexcept {
+        if (bytes == 0 || alignment > page_size())
+            return nullptr;
+
+        const auto length = round_to_pages(bytes);
+    #if MALUNAL_ALLOCATORS_PLATFORM_WIN32
+        constexpr int32_t k_memops = MEM_COMMIT | MEM_RESERVE;
+        constexpr int32_t k_pageops = PAGE_READWRITE;
+        return ::VirtualAlloc(0, length, k_memops, k_pageops);
+    #elif MALUNAL_ALLOCATORS_PLATFORM_POSIX
+        constexpr int32_t k_memops = PROT_READ | PROT_WRITE;
+        constexpr int32_t k_memprms = MAP_PRIVATE | MAP_ANONYMOUS;
+        auto ptr = ::mmap(0, length, k_memops, k_memprms, -1, 0);
+        return ptr != MAP_FAILED ? ptr : nullptr;
+    #else /* Unsupported platform */
+        (void)length;
+        return nullptr;
+    #endif /* Platform specific code */
+    }
+
+protected:
+    /// @brief   Maps the pages for the given number of bytes.
+    /// @param   bytes The amount of bytes to allocate.
+    /// @param   alignment The alignment of the object to be allocated.
+    /// @returns A pointer to the first page.
+    /// @throws  std::bad_alloc If the pages could not be mapped.
+    void*
+    do_allocate(size_t bytes, size_t alignment) override {
+        auto result = try_allocate(bytes, alignment);
+        if (result == nullptr)
+            detail::throw_bad_alloc();
+        return result;
+    }
+
+    /// @brief   Unmaps the pages of the given allocation.
+    /// @param   ptr The pointer to the first page.
+    /// @param   bytes The size of the allocation.
+    /// @param   alignment The alignment of the allocation.
+    void
+    do_deallocate(void* ptr, size_t bytes, size_t alignment) override {
+        (void)alignment;
+    #if MALUNAL_ALLOCATORS_PLATFORM_WIN32
+        (void)bytes;
+        ::VirtualFree(ptr, 0, MEM_RELEASE);
+    #elif MALUNAL_ALLOCATORS_PLATFORM_POSIX
+        ::munmap(ptr, round_to_pages(bytes));
+    #else /* Unsupported platform */
+        (void)ptr;
+        (void)bytes;
+    #endif /* Platform specific code */
+    }
+
+    /// @brief   Checks if the memory resource provided is a page resource.
+    /// @details Page resources hold no state, pages mapped by one can be
+    ///          unmapped by any other.
+    /// @param   other The other memory resource to compare to.
+    /// @returns True if the other memory resource is a page resource.
+    bool
+    do_is_equal(const memory_resource& other) const noexcept override {
+        return dynamic_cast<const self*>(&other) != nullptr;
+    }
+
+private:
+    static size_t
+    round_to_pages(size_t bytes) noexcept {
+        const auto pagem1 = page_size() - 1;
+        return (bytes + pagem1) & ~pagem1;
+    }
+};
+
+
+/// @brief   Provides a default page resource.
+/// @details Page resources hold no state, so a single instance can be shared by
+///          everything that needs one.
+/// @returns A pointer to the default page resource.
+inline page_resource*
+page_allocator_instance() {
+    static page_resource
+    k_page_resource;
+    return &k_page_resource;
+}
+
+} // namespace malunal::allocators
@@ -0,0 +1,192 @@
+/// @file   pointers.hpp
+/// @brief  Provides smart pointers for objects allocated from memory resources.
+/// @author John Christman sorakatadzuma@gmail.com
+/// @copyright 2024 Malunal Studios, LLC.
+#pragma once
+
+
+namespace malunal::allocators {
+
+/// @brief   A deleter which destroys an object and returns its memory to the
+///          memory resource it was allocated from.
+/// @details The only state this deleter stores is the pointer to the memory
+///          resource. The size and alignment of the object are known from its
+///          type, so a unique pointer using this deleter is two pointers wide.
+/// @tparam  T The type of the object being deleted.
+template<typename T>
+struct resource_deleter final {
+    /// @brief The memory resource the object was allocated from.
+    std::pmr::memory_resource* resource{nullptr};
+
+    /// @brief Destroys the object and deallocates its memory.
+    /// @param ptr The pointer to the object to delete.
+    void
+    operator()(T* ptr) const noexcept {
+        std::destroy_at(ptr);
+        resource->deallocate(ptr, sizeof(T), alignof(T));
+    }
+};
+
+/// @brief   A deleter which destroys an object but leaves its memory in place.
+/// @details Use this for objects whose memory is reclaimed all at once by
+///          resetting or releasing the arena they were allocated from. It holds
+///          no state at all, and for trivially destructible types it does
+///          nothing, so a unique pointer using it is as wide as a raw pointer.
+/// @tparam  T The type of the object being deleted.
+/// @remarks This is intentionally not `final`, which would prevent the empty
+///          base optimization inside `std::unique_ptr`.
+template<typename T>
+struct reclaim_deleter {
+    /// @brief Destroys the object without deallocating its memory.
+    /// @param ptr The pointer to the object to destroy.
+    void
+    operator()(T* ptr) const noexcept {
+        if constexpr (!std::is_trivially_destructible_v<T>)
+            std::destroy_at(ptr);
+    }
+};
+
+/// @brief   A minimal allocator which allocates from a memory resource.
+/// @details Unlike `std::pmr::polymorphic_allocator` this allocator does not
+///          perform uses-allocator construction, it only forwards allocation
+///          requests to the memory resource it holds.
+/// @tparam  T The type of the objects being allocated.
+template<typename T>
+struct resource_allocator final {
+    using value_type = T;
+
+    /// @brief The memory resource to allocate from.
+    std::pmr::memory_resource* resource{nullptr};
+
+    /// @brief Constructs the allocator from the given memory resource.
+    /// @param resource The memory resource to allocate from.
+    explicit
+    resource_allocator(std::pmr::memory_resource* resource) noexcept
+        : resource{ resource }
+    {
+        assert(resource != nullptr);
+    }
+
+    /// @brief Constructs the allocator from an allocator of another type.
+    /// @param other The allocator to rebind from.
+    template<typename U>
+    resource_allocator(const resource_allocator<U>& other) noexcept
+        : resource{ other.resource }
+    { }
+
+    /// @brief   Allocates storage for the given number of objects.
+    /// @param   count The number of objects to allocate storage for.
+    /// @returns A pointer to the allocated storage.
+    /// @throws  std::bad_alloc If no memory address could be obtained.
+    T*
+    allocate(size_t count) {
+        return static_cast<T*>(resource->allocate(count * sizeof(T), alignof(T)));
+    }
+
+    /// @brief Deallocates the storage for the given number of objects.
+    /// @param ptr The pointer to the storage to deallocate.
+    /// @param count The number of objects the storage was allocated for.
+    void
+    deallocate(T* ptr, size_t count) noexcept {
+        resource->deallocate(ptr, count * sizeof(T), alignof(T));
+    }
+
+    /// @brief   Checks if two allocators allocate from the same resource.
+    /// @param   other The allocator to compare to.
+    /// @returns True if both allocators hold equal memory resources.
+    template<typename U>
+    bool
+    operator==(const resource_allocator<U>& other) const noexcept {
+        return resource->is_equal(*other.resource);
+    }
+};
+
+
+/// @brief   A unique pointer to an object allocated from a memory resource.
+/// @details The object is destroyed and its memory returned to the memory
+///          resource when the pointer goes out of scope.
+template<typename T>
+using arena_unique_ptr = std::unique_ptr<T, resource_deleter<T>>;
+
+/// @brief   A unique pointer to an object whose memory is reclaimed by its
+///          memory resource rather than by the pointer.
+/// @details The object is destroyed when the pointer goes out of scope, but the
+///          memory stays allocated until the arena is reset or released.
+template<typename T>
+using arena_reclaimed_ptr = std::unique_ptr<T, reclaim_deleter<T>>;
+
+
+namespace detail {
+
+/// @brief   Allocates and constructs an object from the given memory resource.
+/// @details If the constructor of the object throws, the memory is returned to
+///          the memory resource before the exception is rethrown.
+/// @param   resource The memory resource to allocate from.
+/// @param   args The arguments to construct the object with.
+/// @returns A pointer to the constructed object.
+/// @throws  std::bad_alloc If no memory address could be obtained.
+template<typename T, typename... Args>
+T*
+construct_in(std::pmr::memory_resource* resource, Args&&... args) {
+    assert(resource != nullptr);
+    auto memory = resource->allocate(sizeof(T), alignof(T));
+#if MALUNAL_ALLOCATORS_EXCEPTIONS
+    try {
+        return std::construct_at(static_cast<T*>(memory), std::forward<Args>(args)...);
+    } catch (...) {
+        resource->deallocate(memory, sizeof(T), alignof(T));
+        throw;
+    }
+#else
+    return std::construct_at(static_cast<T*>(memory), std::forward<Args>(args)...);
+#endif /* MALUNAL_ALLOCATORS_EXCEPTIONS */
+}
+
+} // namespace detail
+
+
+/// @brief   Constructs an object in the given memory resource and wraps it in
+///          an `arena_unique_ptr`.
+/// @param   resource The memory resource to allocate the object from.
+/// @param   args The arguments to construct the object with.
+/// @returns A unique pointer owning the constructed object.
+/// @throws  std::bad_alloc If no memory address could be obtained.
+template<typename T, typename... Args>
+arena_unique_ptr<T>
+make_arena_unique(std::pmr::memory_resource* resource, Args&&... args) {
+    auto ptr = detail::construct_in<T>(resource, std::forward<Args>(args)...);
+    return arena_unique_ptr<T>(ptr, resource_deleter<T>{ resource });
+}
+
+/// @brief   Constructs an object in the given memory resource and wraps it in
+///          an `arena_reclaimed_ptr`.
+/// @param   resource The memory resource to allocate the object from.
+/// @param   args The arguments to construct the object with.
+/// @returns A unique pointer which destroys, but never deallocates, the object.
+/// @throws  std::bad_alloc If no memory address could be obtained.
+template<typename T, typename... Args>
+arena_reclaimed_ptr<T>
+make_arena_reclaimed(std::pmr::memory_resource* resource, Args&&... args) {
+    auto ptr = detail::construct_in<T>(resource, std::forward<Args>(args)...);
+    return arena_reclaimed_ptr<T>(ptr);
+}
+
+/// @brief   Constructs an object in the given memory resource with shared
+///          ownership.
+/// @details The control block and the object share a single allocation from
+///          the memory resource, and the control block stores nothing more
+///          than the memory resource pointer to release it.
+/// @param   resource The memory resource to allocate the object from.
+/// @param   args The arguments to construct the object with.
+/// @returns A shared pointer owning the constructed object.
+/// @throws  std::bad_alloc If no memory address could be obtained.
+template<typename T, typename... Args>
+std::shared_ptr<T>
+allocate_shared_in(std::pmr::memory_resource* resource, Args&&... args) {
+    return std::allocate_shared<T>(
+        resource_allocator<T>(resource),
+        std::forward<Args>(args)...
+    );
+}
+
+} // namespace malunal::allocators
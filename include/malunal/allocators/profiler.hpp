@@ -0,0 +1,453 @@
+/// @file   profiler.hpp
+/// @brief  Provides the sampling heap profiler.
+/// @author John Christman sorakatadzuma@gmail.com
+/// @copyright 2024 Malunal Studios, LLC.
+#pragma once
+
+
+#if MALUNAL_ALLOCATORS_PLATFORM_POSIX && __has_include(<execinfo.h>)
+#include <execinfo.h>
+#define MALUNAL_ALLOCATORS_HAS_BACKTRACE 1
+#elif MALUNAL_ALLOCATORS_PLATFORM_WIN32
+#define WIN32_LEAN_AND_MEAN 1
+#define NOMINMAX 1
+#include <windows.h>
+#define MALUNAL_ALLOCATORS_HAS_BACKTRACE 1
+#else
+#define MALUNAL_ALLOCATORS_HAS_BACKTRACE 0
+#endif /* Platform specific headers */
+
+
+// Set profiler stack depth if not yet set.
+#ifndef MALUNAL_ALLOCATORS_PROFILER_STACK_DEPTH
+/// @def     MALUNAL_ALLOCATORS_PROFILER_STACK_DEPTH
+/// @brief   The number of frames captured for each sampled allocation.
+/// @details This is modifiable by you the developer. It configures how many
+///          return addresses the heap profiler keeps for every sample, deeper
+///          stacks cost more time to capture and more memory to keep. The lower
+///          bounds is 1 and the upper bounds is 128.
+#define MALUNAL_ALLOCATORS_PROFILER_STACK_DEPTH 32
+#elif MALUNAL_ALLOCATORS_PROFILER_STACK_DEPTH < 1 || \
+      MALUNAL_ALLOCATORS_PROFILER_STACK_DEPTH > 128
+#  error Profiler stack depth must be >= 1 and <= 128
+#endif /* MALUNAL_ALLOCATORS_PROFILER_STACK_DEPTH */
+
+
+namespace malunal::allocators {
+
+/// @brief   The number of frames captured for each sampled allocation.
+/// @details This is controlled by a macro which you, the developer, can
+///          adjust to your needs.
+inline static constexpr size_t
+k_profiler_stack_depth = MALUNAL_ALLOCATORS_PROFILER_STACK_DEPTH;
+
+/// @brief   The default average number of bytes between two samples.
+inline static constexpr size_t
+k_default_sample_rate = 512 * 1024;
+
+
+/// @brief   A heap profiler which samples about one in every `sample_rate`
+///          bytes allocated, and keeps the call stack of each sampled
+///          allocation for as long as the allocation is live.
+/// @details Every allocation counts its size down from a randomized interval,
+///          drawn from an exponential distribution with a mean of the sample
+///          rate, and only the allocation which crosses zero is sampled. Large
+///          allocations are therefore almost always sampled and small ones
+///          rarely, so the profile is an unbiased estimate of where the bytes
+///          went at a cost of one atomic subtraction per allocation.
+///
+///          Samples are grouped by call stack. The profile written by
+///          `write_profile()` is in the legacy heap profile text format, which
+///          `pprof` reads and scales back up by the sample rate:
+///
+///              pprof -http=: ./program heap.prof
+///
+///          The profiler plugs into the arena memory resource through its
+///          `hooks()`, or into any memory resource through the
+///          `profiling_resource` adapter.
+/// @remarks The first capture may allocate from `malloc` while the unwinder
+///          is loaded, so the profiler must not sit underneath `malloc`.
+struct heap_profiler {
+    using self = heap_profiler;
+
+    /// @brief   Constructs the heap profiler with the given sample rate.
+    /// @param   sample_rate The average number of bytes between two samples, a
+    ///          rate of 1 samples every allocation.
+    explicit
+    heap_profiler(size_t sample_rate = k_default_sample_rate) noexcept
+        : sample_rate_{ std::max<size_t>(sample_rate, 1) }
+        , random_{ reinterpret_cast<uintptr_t>(this) | 1 }
+    {
+        countdown_.store(next_interval(), std::memory_order_relaxed);
+    }
+
+    heap_profiler(const heap_profiler& other) = delete;
+
+    heap_profiler&
+    operator=(const heap_profiler& other) = delete;
+
+    /// @brief   Records an allocation, sampling it if its bytes cross the end of
+    ///          the current sampling interval.
+    /// @param   ptr The pointer that was allocated.
+    /// @param   bytes The size of the allocation.
+    void
+    record_allocation(void* ptr, size_t bytes) noexcept {
+        const auto size = static_cast<int64_t>(bytes);
+        if (countdown_.fetch_sub(size, std::memory_order_relaxed) > size)
+            return;
+
+        sample(ptr, bytes);
+    }
+
+    /// @brief   Records a deallocation, dropping its sample if it had one.
+    /// @details The pointer is checked against a filter of the live samples
+    ///          first, which never misses a sampled pointer, so the frees of
+    ///          allocations that were not sampled are a single relaxed load.
+    /// @param   ptr The pointer that is deallocated.
+    void
+    record_deallocation(void* ptr) noexcept {
+        auto& filter = filter_[filter_index(ptr)];
+        if (filter.load(std::memory_order_relaxed) == 0)
+            return;
+
+        std::lock_guard lock(mutex_);
+        auto itr = live_.find(ptr);
+        if (itr == live_.end())
+            return;
+
+        itr->second.owner->inuse_count--;
+        itr->second.owner->inuse_bytes -= itr->second.bytes;
+        live_.erase(itr);
+        live_count_.fetch_sub(1, std::memory_order_relaxed);
+        filter.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    /// @brief   Provides allocation hooks which feed this heap profiler.
+    /// @details Install these on an arena memory resource with `set_hooks()`,
+    ///          this requires `MALUNAL_ALLOCATORS_ENABLE_HOOKS`. The profiler
+    ///          must outlive the arena, or have its hooks removed first.
+    /// @returns The allocation hooks with this profiler as their context.
+    allocation_hooks
+    hooks() noexcept {
+        return allocation_hooks {
+            .context = this,
+            .on_allocate = [](void* context, void* ptr, size_t bytes, size_t) {
+                static_cast<self*>(context)->record_allocation(ptr, bytes);
+            },
+            .on_deallocate = [](void* context, void* ptr, size_t, size_t) {
+                static_cast<self*>(context)->record_deallocation(ptr);
+            }
+        };
+    }
+
+    /// @brief   Provides the average number of bytes between two samples.
+    /// @returns The sample rate in bytes.
+    size_t
+    sample_rate() const noexcept {
+        return sample_rate_;
+    }
+
+    /// @brief   Provides the number of sampled allocations still live.
+    /// @returns The number of live samples.
+    size_t
+    live_samples() const noexcept {
+        return live_count_.load(std::memory_order_relaxed);
+    }
+
+    /// @brief   Writes the profile of the live samples, and of every sample taken
+    ///          so far, in the legacy heap profile format read by `pprof`.
+    /// @details On Linux the memory map of the process is appended, so `pprof`
+    ///          can symbolize the addresses of shared libraries.
+    /// @param   file The file to write the profile to.
+    /// @returns True if the profile was written; false otherwise.
+    bool
+    write_profile(std::FILE* file) const {
+        if (file == nullptr)
+            return false;
+
+        std::lock_guard lock(mutex_);
+        bucket total{};
+        for (const auto& [stack, counts] : buckets_) {
+            total.inuse_count += counts.inuse_count;
+            total.inuse_bytes += counts.inuse_bytes;
+            total.alloc_count += counts.alloc_count;
+            total.alloc_bytes += counts.alloc_bytes;
+        }
+
+        std::fprintf(file, "heap profile: ");
+        write_counts(file, total);
+        std::fprintf(file, " @ heap_v2/%zu\n", sample_rate_);
+        for (const auto& [stack, counts] : buckets_) {
+            write_counts(file, counts);
+            std::fprintf(file, " @");
+            for (size_t index = 0; index < stack.depth; index++)
+                std::fprintf(file, " %p", stack.frames[index]);
+            std::fprintf(file, "\n");
+        }
+
+        write_mapped_libraries(file);
+        return std::ferror(file) == 0;
+    }
+
+    /// @brief   Writes the profile to the file at the given path.
+    /// @param   path The path of the file to write the profile to.
+    /// @returns True if the profile was written; false otherwise.
+    bool
+    write_profile(const char* path) const {
+        auto file = std::fopen(path, "w");
+        if (file == nullptr)
+            return false;
+
+        const auto result = write_profile(file);
+        return std::fclose(file) == 0 && result;
+    }
+
+private:
+    /// @brief The call stack of a sampled allocation.
+    struct stack_trace final {
+        std::array<void*, k_profiler_stack_depth> frames{};
+        size_t depth{0};
+
+        bool
+        operator==(const stack_trace& other) const noexcept {
+            return depth == other.depth &&
+                std::equal(frames.begin(), frames.begin() + depth, other.frames.begin());
+        }
+    };
+
+    /// @brief Hashes a call stack by its return addresses.
+    struct stack_hash final {
+        size_t
+        operator()(const stack_trace& stack) const noexcept {
+            auto result = static_cast<size_t>(stack.depth);
+            for (size_t index = 0; index < stack.depth; index++) {
+                const auto frame = reinterpret_cast<uintptr_t>(stack.frames[index]);
+                result = (result ^ frame) * 0x9E37'79B9'7F4A'7C15;
+            }
+            return result;
+        }
+    };
+
+    /// @brief The samples taken with the same call stack.
+    struct bucket final {
+        size_t inuse_count{0};
+        size_t inuse_bytes{0};
+        size_t alloc_count{0};
+        size_t alloc_bytes{0};
+    };
+
+    /// @brief A sampled allocation which is still live.
+    struct live_sample final {
+        bucket* owner;
+        size_t  bytes;
+    };
+
+    /// @brief The number of counters in the filter of live samples.
+    inline static constexpr size_t
+    k_filter_size = 4096;
+
+    size_t                sample_rate_;
+    uint64_t              random_;
+    std::atomic<int64_t>  countdown_{0};
+    std::atomic<size_t>   live_count_{0};
+    mutable std::mutex    mutex_;
+
+    std::unordered_map<stack_trace, bucket, stack_hash> buckets_;
+    std::unordered_map<void*, live_sample>              live_;
+
+    // Counts the live samples whose pointers hash to each slot, a slot of 0
+    // proves the pointer was not sampled without taking the mutex.
+    std::array<std::atomic<uint32_t>, k_filter_size> filter_{};
+
+    static size_t
+    filter_index(const void* ptr) noexcept {
+        constexpr auto k_shift = 64 - std::countr_zero(k_filter_size);
+        const auto address = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(ptr));
+        return static_cast<size_t>((address >> 4) * 0x9E37'79B9'7F4A'7C15 >> k_shift);
+    }
+
+
+    int64_t
+    next_interval() noexcept {
+        // A rate of 1 samples every allocation, drawing an interval for it
+        // would skip the allocations whose bytes fall short of the draw.
+        if (sample_rate_ == 1)
+            return 1;
+
+        // Exponentially distributed intervals make every byte equally likely to
+        // be sampled, a fixed interval would alias with allocation patterns.
+        random_ ^= random_ << 13;
+        random_ ^= random_ >> 7;
+        random_ ^= random_ << 17;
+        const auto uniform  = static_cast<double>((random_ >> 11) + 1) * 0x1.0p-53;
+        const auto interval = -std::log(uniform) * static_cast<double>(sample_rate_);
+        return static_cast<int64_t>(interval) + 1;
+    }
+
+    void
+    sample(void* ptr, size_t bytes) noexcept {
+        stack_trace stack;
+        stack.depth = capture(stack.frames.data(), stack.frames.size());
+
+        std::lock_guard lock(mutex_);
+        // Another thread may have crossed the same interval and taken the
+        // sample already, only the first one to get here takes it.
+        if (countdown_.load(std::memory_order_relaxed) > 0)
+            return;
+        countdown_.store(next_interval(), std::memory_order_relaxed);
+
+    #if MALUNAL_ALLOCATORS_EXCEPTIONS
+        try {
+            insert(ptr, bytes, stack);
+        } catch (const std::bad_alloc&) {
+            // The sample is dropped, the profile is an estimate anyway.
+        }
+    #else
+        insert(ptr, bytes, stack);
+    #endif /* MALUNAL_ALLOCATORS_EXCEPTIONS */
+    }
+
+    void
+    insert(void* ptr, size_t bytes, const stack_trace& stack) {
+        auto& owner = buckets_[stack];
+        owner.inuse_count++;
+        owner.inuse_bytes += bytes;
+        owner.alloc_count++;
+        owner.alloc_bytes += bytes;
+        if (live_.insert_or_assign(ptr, live_sample{ &owner, bytes }).second) {
+            live_count_.fetch_add(1, std::memory_order_relaxed);
+            filter_[filter_index(ptr)].fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    static size_t
+    capture(void** frames, size_t depth) noexcept {
+    #if MALUNAL_ALLOCATORS_PLATFORM_WIN32
+        return ::CaptureStackBackTrace(2, static_cast<DWORD>(depth), frames, nullptr);
+    #elif MALUNAL_ALLOCATORS_HAS_BACKTRACE
+        // Skip the frames of the profiler itself.
+        constexpr size_t k_skipped = 2;
+        void* buffer[k_profiler_stack_depth + k_skipped];
+        const auto count = static_cast<size_t>(::backtrace(buffer, static_cast<int>(depth + k_skipped)));
+        if (count <= k_skipped)
+            return 0;
+
+        std::copy(buffer + k_skipped, buffer + count, frames);
+        return count - k_skipped;
+    #else /* Unsupported platform */
+        (void)frames;
+        (void)depth;
+        return 0;
+    #endif /* Platform specific code */
+    }
+
+    static void
+    write_counts(std::FILE* file, const bucket& counts) noexcept {
+        std::fprintf(file, "%zu: %zu [%zu: %zu]",
+            counts.inuse_count, counts.inuse_bytes,
+            counts.alloc_count, counts.alloc_bytes);
+    }
+
+    static void
+    write_mapped_libraries(std::FILE* file) noexcept {
+    #if MALUNAL_ALLOCATORS_PLATFORM_POSIX
+        auto maps = std::fopen("/proc/self/maps", "r");
+        if (maps == nullptr)
+            return;
+
+        std::fprintf(file, "\nMAPPED_LIBRARIES:\n");
+        char buffer[4096];
+        size_t count;
+        while ((count = std::fread(buffer, 1, sizeof(buffer), maps)) != 0)
+            std::fwrite(buffer, 1, count, file);
+        std::fclose(maps);
+    #else /* Unsupported platform */
+        (void)file;
+    #endif /* Platform specific code */
+    }
+};
+
+
+/// @brief   A profiling resource is a memory resource adapter which forwards
+///          every allocation to an upstream memory resource, and reports it to
+///          a heap profiler.
+/// @details This profiles memory resources which have no allocation hooks, or
+///          an arena memory resource built without them.
+struct profiling_resource : std::pmr::memory_resource {
+    using upstream = std::pmr::memory_resource;
+    using super    = std::pmr::memory_resource;
+    using self     = profiling_resource;
+
+    /// @brief   Constructs the profiling resource on top of the given upstream
+    ///          memory resource.
+    /// @details Neither the profiler nor the upstream memory resource is owned
+    ///          by the profiling resource, they must outlive it.
+    /// @param   profiler The heap profiler to report to, must not be `nullptr`.
+    /// @param   upstream The memory resource to forward the allocations to,
+    ///          must not be `nullptr`.
+    profiling_resource(heap_profiler* profiler, upstream* upstream) noexcept
+        : profiler_{ profiler }
+        , upstream_{ upstream }
+    {
+        assert(profiler != nullptr);
+        assert(upstream != nullptr);
+    }
+
+    /// @brief   Provides the heap profiler of this profiling resource.
+    /// @returns A pointer to the heap profiler.
+    heap_profiler*
+    profiler() const noexcept {
+        return profiler_;
+    }
+
+    /// @brief   Provides the upstream memory resource of this profiling resource.
+    /// @returns A pointer to the upstream memory resource.
+    upstream*
+    upstream_resource() const noexcept {
+        return upstream_;
+    }
+
+protected:
+    /// @brief   Allocates from the upstream memory resource and reports the
+    ///          allocation to the heap profiler.
+    /// @param   bytes The amount of bytes to allocate.
+    /// @param   alignment The alignment of the object to be allocated.
+    /// @returns A pointer to where the data can be stored.
+    /// @throws  std::bad_alloc If no memory address could be obtained.
+    void*
+    do_allocate(size_t bytes, size_t alignment) override {
+        auto result = upstream_->allocate(bytes, alignment);
+        profiler_->record_allocation(result, bytes);
+        return result;
+    }
+
+    /// @brief   Reports the deallocation to the heap profiler and deallocates
+    ///          from the upstream memory resource.
+    /// @param   ptr The pointer to the object to deallocate.
+    /// @param   bytes The size of the object to deallocate.
+    /// @param   alignment The alignment of the object to deallocate.
+    void
+    do_deallocate(void* ptr, size_t bytes, size_t alignment) override {
+        profiler_->record_deallocation(ptr);
+        upstream_->deallocate(ptr, bytes, alignment);
+    }
+
+    /// @brief   Checks if the memory resource provided is a profiling resource
+    ///          over the same upstream memory resource.
+    /// @param   other The other memory resource to compare to.
+    /// @returns True if the other memory resource profiles the same upstream
+    ///          memory resource into the same profiler; false otherwise.
+    bool
+    do_is_equal(const memory_resource& other) const noexcept override {
+        auto casted = dynamic_cast<const self*>(&other);
+        return casted    != nullptr           &&
+               profiler_ == casted->profiler_ &&
+               upstream_ == casted->upstream_;
+    }
+
+private:
+    heap_profiler* profiler_{nullptr};
+    upstream*      upstream_{nullptr};
+};
+
+} // namespace malunal::allocators
@@ -13,7 +13,10 @@ namespace malunal::allocators {
 /// @details For all intents and purposes, this memory resource is simply a push
 ///          pointer allocator. Once it runs out of the memory in the buffer
 ///          that it was constructed from, it will try and acquire more from an
-///          upstream
+///          upstream memory resource, and continue pushing the pointer forward
+///          in that new buffer. The buffers acquired from the upstream are
+///          returned to it when the scratch buffer resource is reset or
+///          destroyed.
 struct scratch_buffer_resource : linear_buffer_resource {
     using upstream = std::pmr::memory_resource;
     using super    = linear_buffer_resource;
@@ -30,10 +33,17 @@ struct scratch_buffer_resource : linear_buffer_resource {
     ///          utilizes to allocate into.
     /// @param   length The length of the buffer the scratch buffer resource
     ///          will be allocating into.
+    /// @param   mode How deallocations are handled by the scratch buffer
+    ///          resource.
     scratch_buffer_resource(
-        void*  buffer,
-        size_t length
-    ) noexcept : super(buffer, length) {
+        void*       buffer,
+        size_t      length,
+        linear_mode mode = linear_mode::monotonic
+    ) noexcept
+        : super(buffer, length, mode)
+        , buffer_{ buffer }
+        , length_{ length }
+    {
     }
 
     /// @brief   Constructs the scratch buffer resource from the given buffer,
@@ -42,36 +52,104 @@ struct scratch_buffer_resource : linear_buffer_resource {
     ///          the additional requirement that the provided `upstream` memory
     ///          resource is also not nullptr. If you didn't need an upstream
     ///          resource, use the other constructor.
-    /// @param buffer 
-    /// @param length 
-    /// @param upstream 
+    /// @param   buffer A pointer to the buffer that the scratch buffer resource
+    ///          utilizes to allocate into.
+    /// @param   length The length of the buffer the scratch buffer resource
+    ///          will be allocating into.
+    /// @param   upstream The memory resource to acquire more buffers from once
+    ///          the buffer is full.
+    /// @param   mode How deallocations are handled by the scratch buffer
+    ///          resource.
     scratch_buffer_resource(
-        void*     buffer,
-        size_t    length,
-        upstream* upstream
+        void*       buffer,
+        size_t      length,
+        upstream*   upstream,
+        linear_mode mode = linear_mode::monotonic
     ) noexcept
-        : super(buffer, length)
+        : super(buffer, length, mode)
         , upstream_{ upstream }
+        , buffer_{ buffer }
+        , length_{ length }
     {
         assert(upstream != nullptr);
     }
 
+    scratch_buffer_resource(const scratch_buffer_resource& other) = delete;
+
+    scratch_buffer_resource&
+    operator=(const scratch_buffer_resource& other) = delete;
 
-    /// @brief Provided for overriding classes to properly destruct themselves.
+    /// @brief   Returns the buffers acquired from the upstream memory resource.
+    /// @details Provided for overriding classes to properly destruct themselves.
     virtual
-    ~scratch_buffer_resource() noexcept = default;
+    ~scratch_buffer_resource() noexcept {
+        release_overflow();
+    }
+
+    /// @brief   Resets the scratch buffer resource to its original buffer.
+    /// @details Every buffer acquired from the upstream memory resource is
+    ///          returned to it, and the used count of the original buffer is
+    ///          reset to 0 so it can be used again.
+    /// @remarks This hides `linear_buffer_resource::reset()`, so reset the
+    ///          scratch buffer resource through its own type.
+    void
+    reset() noexcept {
+        release_overflow();
+        super::reset();
+    }
+
+    /// @brief   Checks if the given pointer points into the original buffer or
+    ///          any of the buffers acquired from the upstream memory resource.
+    /// @details The original buffer is a constant time check; every buffer
+    ///          acquired from the upstream adds one more bounds check.
+    /// @param   ptr The pointer to check.
+    /// @returns True if the pointer is within one of the buffers; false
+    ///          otherwise.
+    bool
+    owns(const void* ptr) const noexcept {
+        const auto address = reinterpret_cast<uintptr_t>(ptr);
+        const auto begin   = reinterpret_cast<uintptr_t>(buffer_);
+        if (begin <= address && address < begin + length_)
+            return true;
+
+        for (auto temp = overflow_; temp != nullptr; temp = temp->prev) {
+            const auto block = reinterpret_cast<uintptr_t>(temp);
+            if (block + k_overflow_header <= address && address < block + temp->length)
+                return true;
+        }
+
+        return false;
+    }
+
+    /// @brief   Allocates a piece of the buffer by the given size in bytes and
+    ///          aligned to the provided alignment, without throwing.
+    /// @details This will try to allocate using the linear buffer resource
+    ///          first (it's parent), and if that fails, it will acquire a new
+    ///          buffer from the upstream memory resource that is at least as
+    ///          large as the original buffer, and allocate from that one.
+    /// @param   bytes The amount of bytes to allocate.
+    /// @param   alignment The alignment for determining the byte boundary where
+    ///          the resulting pointer should start.
+    /// @returns A pointer to where the data can be stored, or `nullptr` if
+    ///          neither the buffer nor the upstream could provide the memory.
+    void*
+    try_allocate(size_t bytes, size_t alignment) noexcept {
+        auto result = super::try_allocate(bytes, alignment);
+        if (result != nullptr || upstream_ == nullptr)
+            return result;
+
+        if (!try_upstream_acquire(bytes, alignment))
+            return nullptr;
+        return super::try_allocate(bytes, alignment);
+    }
 
 
 protected:
     /// @brief   Allocates a piece of the buffer by the given size in bytes and
     ///          aligned to the provided alignment.
-    /// @details This implementation will try to allocate using the linear
-    ///          buffer resource first (it's parent), and if that fails, it will
-    ///          try the upstream memory resource. In the event that the
-    ///          upstream is able to provide data, it will update the super's
-    ///          tracked buffer to the new one. In the event that both memory
-    ///          resources are unable to provide a memory address, this will
-    ///          throw `std::bad_alloc`.
+    /// @details Delegates to `try_allocate()`. In the event that both the
+    ///          buffer and the upstream memory resource are unable to provide
+    ///          a memory address, this will throw `std::bad_alloc`.
     /// @param   bytes The amount of bytes to allocate.
     /// @param   alignment The alignment for determining the byte boundary where
     ///          the resulting pointer should start.
@@ -79,31 +157,21 @@ protected:
     /// @throws  std::bad_alloc If no memory address could be obtained.
     void*
     do_allocate(size_t bytes, size_t alignment) override {
-        void* result;
-        
-        result = try_super_allocate(bytes, alignment);
-        if (result != nullptr)
-            return result;
-        
-        result = try_upstream_allocate(bytes, alignment);
-        if (result != nullptr) {
-            change_buffer(result, bytes);
-            return result;
-        }
-        
-        // Could not allocate at all.
-        throw std::bad_alloc();
+        auto result = try_allocate(bytes, alignment);
+        if (result == nullptr)
+            detail::throw_bad_alloc();
+        return result;
     }
 
     /// @brief   Deallcoates the given pointer from the scratch buffer resource.
-    /// @details This will call the super method only, and the super method will
-    ///          not deallocate anything because it's simply a push pointer
-    ///          resource.
+    /// @details This will call the super method only, which only reclaims the
+    ///          most recent allocation of the current buffer, and only when the
+    ///          scratch buffer resource was constructed with `linear_mode::lifo`.
     /// @param   ptr The pointer to deallocate.
     /// @param   bytes The number of bytes of the object being deallocated.
     /// @param   alignment The alignment of the object being deallocated.
     void
-    do_deallocate(void* ptr, size_t bytes, size_t alignment) {
+    do_deallocate(void* ptr, size_t bytes, size_t alignment) override {
         super::do_deallocate(ptr, bytes, alignment);
     }
 
@@ -127,29 +195,66 @@ protected:
     }
 
 private:
+    /// @brief   The header placed at the start of every buffer acquired from
+    ///          the upstream memory resource.
+    /// @details It links the buffer to the previously acquired one so they can
+    ///          all be returned to the upstream memory resource.
+    struct overflow final {
+        overflow* prev;
+        size_t    length;
+    };
+
+    inline static constexpr size_t
+    k_overflow_alignment = alignof(std::max_align_t);
+
+    inline static constexpr size_t
+    k_overflow_header = (sizeof(overflow) + k_overflow_alignment - 1) & ~(k_overflow_alignment - 1);
+
     upstream* upstream_{nullptr};
+    overflow* overflow_{nullptr};
+    void*     buffer_{nullptr};
+    size_t    length_{0};
 
-    void*
-    try_super_allocate(size_t bytes, size_t alignment) {
-        void* result{nullptr};
-        try {
-            result = super::do_allocate(bytes, alignment);
-        } catch (const std::bad_alloc&) {
+    void
+    release_overflow() noexcept {
+        if (overflow_ == nullptr)
+            return;
+
+        while (overflow_ != nullptr) {
+            auto prev = overflow_->prev;
+            upstream_->deallocate(overflow_, overflow_->length, k_overflow_alignment);
+            overflow_ = prev;
         }
 
-        return result;
+        super::reset();
+        change_buffer(buffer_, length_);
     }
 
-    void*
-    try_upstream_allocate(size_t bytes, size_t alignment) {
+    bool
+    try_upstream_acquire(size_t bytes, size_t alignment) noexcept {
+        const auto length = k_overflow_header + std::max(length_, bytes + alignment);
+
         void* result{nullptr};
+    #if MALUNAL_ALLOCATORS_EXCEPTIONS
         try {
-            if (upstream_ != nullptr)
-                upstream_->deallocate(result, bytes, alignment);
+            result = upstream_->allocate(length, k_overflow_alignment);
         } catch (const std::bad_alloc&) {
+            return false;
         }
+    #else
+        result = upstream_->allocate(length, k_overflow_alignment);
+    #endif /* MALUNAL_ALLOCATORS_EXCEPTIONS */
 
-        return result;
+        auto block = static_cast<overflow*>(result);
+        block->prev   = overflow_;
+        block->length = length;
+        overflow_     = block;
+
+        // Start pushing the pointer forward in the new buffer.
+        const auto begin = reinterpret_cast<uintptr_t>(result) + k_overflow_header;
+        super::reset();
+        change_buffer(reinterpret_cast<void*>(begin), length - k_overflow_header);
+        return true;
     }
 };
 
@@ -0,0 +1,448 @@
+/// @file   tagging.hpp
+/// @brief  Provides allocation tagging with per tag statistics.
+/// @author John Christman sorakatadzuma@gmail.com
+/// @copyright 2024 Malunal Studios, LLC.
+#pragma once
+
+
+// Disable allocation tagging if not yet set.
+#ifndef MALUNAL_ALLOCATORS_ENABLE_TAGGING
+/// @def     MALUNAL_ALLOCATORS_ENABLE_TAGGING
+/// @brief   Enables the per tag allocation statistics.
+/// @details This is modifiable by you the developer. When set to 1, every
+///          allocation made with an `allocation_tag` is counted against that
+///          tag. When set to 0, the default, tags are empty and every count is
+///          compiled out, so tagged code costs nothing.
+#define MALUNAL_ALLOCATORS_ENABLE_TAGGING 0
+#endif /* MALUNAL_ALLOCATORS_ENABLE_TAGGING */
+
+// Set tag table size if not yet set.
+#ifndef MALUNAL_ALLOCATORS_TAGGING_TABLE_SIZE
+/// @def     MALUNAL_ALLOCATORS_TAGGING_TABLE_SIZE
+/// @brief   The number of distinct tags which can be counted.
+/// @details This is modifiable by you the developer. It configures how many
+///          tags, source locations and user tags combined, get counters of
+///          their own. Anything beyond that is counted against a single
+///          overflow tag. The value must be a power of two, the lower bounds is
+///          16 and the upper bounds is 65536.
+#define MALUNAL_ALLOCATORS_TAGGING_TABLE_SIZE 256
+#elif MALUNAL_ALLOCATORS_TAGGING_TABLE_SIZE < 16    || \
+      MALUNAL_ALLOCATORS_TAGGING_TABLE_SIZE > 65536 || \
+      (MALUNAL_ALLOCATORS_TAGGING_TABLE_SIZE & (MALUNAL_ALLOCATORS_TAGGING_TABLE_SIZE - 1)) != 0
+#  error Tagging table size must be a power of two, >= 16 and <= 65536
+#endif /* MALUNAL_ALLOCATORS_TAGGING_TABLE_SIZE */
+
+
+namespace malunal::allocators {
+
+/// @brief   Whether allocation tagging is compiled in.
+/// @details This is controlled by a macro which you, the developer, can
+///          adjust to your needs.
+inline static constexpr bool
+k_tagging_enabled = MALUNAL_ALLOCATORS_ENABLE_TAGGING != 0;
+
+/// @brief   The number of distinct tags which can be counted.
+/// @details This is controlled by a macro which you, the developer, can
+///          adjust to your needs.
+inline static constexpr size_t
+k_tagging_table_size = MALUNAL_ALLOCATORS_TAGGING_TABLE_SIZE;
+
+
+/// @brief   A snapshot of the statistics of a single allocation tag.
+/// @details Source location tags carry their file, line and function, user
+///          tags carry the value of their enumerator instead. The overflow tag
+///          has neither.
+struct tag_stats final {
+    /// @brief The file of a source location tag, or `nullptr`.
+    const char* file{nullptr};
+
+    /// @brief The function of a source location tag, or `nullptr`.
+    const char* function{nullptr};
+
+    /// @brief The line of a source location tag, or the value of a user tag.
+    uint32_t line{0};
+
+    /// @brief The number of bytes currently allocated with the tag.
+    size_t bytes{0};
+
+    /// @brief The number of allocations made with the tag which are still live.
+    size_t live{0};
+
+    /// @brief The most bytes ever allocated with the tag at once.
+    size_t peak{0};
+
+    /// @brief The number of allocations ever made with the tag.
+    size_t allocations{0};
+};
+
+
+namespace detail {
+
+/// @brief   The counters of a single allocation tag.
+/// @details The key is the file name of a source location, or a marker unique
+///          to the enumeration type of a user tag, together with the line or
+///          enumerator value. Every field is atomic so tags can be counted from
+///          any number of threads without a lock.
+struct tag_counters final {
+    std::atomic<const void*> domain{nullptr};
+    uint32_t                 line{0};
+    const char*              file{nullptr};
+    const char*              function{nullptr};
+    std::atomic<size_t>      bytes{0};
+    std::atomic<size_t>      live{0};
+    std::atomic<size_t>      peak{0};
+    std::atomic<size_t>      allocations{0};
+
+    void
+    allocated(size_t size) noexcept {
+        const auto current = bytes.fetch_add(size, std::memory_order_relaxed) + size;
+        live.fetch_add(1, std::memory_order_relaxed);
+        allocations.fetch_add(1, std::memory_order_relaxed);
+
+        auto highest = peak.load(std::memory_order_relaxed);
+        while (highest < current &&
+               !peak.compare_exchange_weak(highest, current, std::memory_order_relaxed));
+    }
+
+    void
+    deallocated(size_t size) noexcept {
+        bytes.fetch_sub(size, std::memory_order_relaxed);
+        live.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    tag_stats
+    stats() const noexcept {
+        return tag_stats {
+            .file        = file,
+            .function    = function,
+            .line        = line,
+            .bytes       = bytes.load(std::memory_order_relaxed),
+            .live        = live.load(std::memory_order_relaxed),
+            .peak        = peak.load(std::memory_order_relaxed),
+            .allocations = allocations.load(std::memory_order_relaxed)
+        };
+    }
+};
+
+/// @brief   A marker whose address identifies the enumeration type of a user
+///          tag.
+template<typename Enum>
+inline constexpr char enum_tag_domain = 0;
+
+/// @brief   The lock-free table of tag counters.
+/// @details Tags are found by open addressing. An empty slot is claimed by
+///          swapping its domain from `nullptr` to a busy marker, filling it in,
+///          and then publishing the real domain; a thread which finds a slot
+///          being claimed waits for that to finish. Slots are never released.
+struct tag_table final {
+    inline static constexpr char k_busy = 0;
+
+    std::array<tag_counters, k_tagging_table_size> slots;
+    tag_counters                                   overflow;
+
+    tag_counters*
+    find(const void* domain, uint32_t line, const char* file, const char* function) noexcept {
+        const auto key   = reinterpret_cast<uintptr_t>(domain) ^ (uintptr_t{line} * 0x9E37'79B9);
+        const auto mask  = k_tagging_table_size - 1;
+        auto       index = static_cast<size_t>((key >> 4) ^ key) & mask;
+        for (size_t probe = 0; probe < k_tagging_table_size; probe++, index = (index + 1) & mask) {
+            auto& slot    = slots[index];
+            auto  current = slot.domain.load(std::memory_order_acquire);
+            if (current == nullptr) {
+                if (slot.domain.compare_exchange_strong(current, &k_busy, std::memory_order_acquire)) {
+                    slot.line     = line;
+                    slot.file     = file;
+                    slot.function = function;
+                    slot.domain.store(domain, std::memory_order_release);
+                    return &slot;
+                }
+            }
+
+            while (current == &k_busy)
+                current = slot.domain.load(std::memory_order_acquire);
+            if (current == domain && slot.line == line)
+                return &slot;
+        }
+
+        return &overflow;
+    }
+};
+
+/// @brief   Provides the table of tag counters shared by the whole program.
+/// @returns A reference to the tag table.
+inline tag_table&
+tags() noexcept {
+    static tag_table
+    k_tags;
+    return k_tags;
+}
+
+} // namespace detail
+
+
+/// @brief   A handle to the counters of an allocation tag.
+/// @details A tag is either the source location it was made at, or the
+///          enumerator of a user defined enumeration, which is how allocations
+///          are attributed to a subsystem. Making a tag looks it up in a
+///          lock-free table, so keep the tag around rather than making it for
+///          every allocation:
+///
+///              static const auto k_tag = allocation_tag(subsystem::audio);
+///              auto ptr = tagged_allocate(&arena, 64, 8, k_tag);
+///
+///          When `MALUNAL_ALLOCATORS_ENABLE_TAGGING` is 0 the handle is empty
+///          and every count compiles away.
+struct allocation_tag final {
+    /// @brief   Makes the tag of the given source location.
+    /// @param   location The source location, the caller by default.
+    explicit
+    allocation_tag(std::source_location location = std::source_location::current()) noexcept {
+    #if MALUNAL_ALLOCATORS_ENABLE_TAGGING
+        counters_ = detail::tags().find(
+            location.file_name(),
+            location.line(),
+            location.file_name(),
+            location.function_name()
+        );
+    #else
+        (void)location;
+    #endif /* MALUNAL_ALLOCATORS_ENABLE_TAGGING */
+    }
+
+    /// @brief   Makes the tag of the given enumerator.
+    /// @tparam  Enum The user defined enumeration of tags.
+    /// @param   tag The enumerator to count allocations against.
+    template<typename Enum>
+        requires std::is_enum_v<Enum>
+    explicit
+    allocation_tag(Enum tag) noexcept {
+    #if MALUNAL_ALLOCATORS_ENABLE_TAGGING
+        counters_ = detail::tags().find(
+            &detail::enum_tag_domain<Enum>,
+            static_cast<uint32_t>(tag),
+            nullptr,
+            nullptr
+        );
+    #else
+        (void)tag;
+    #endif /* MALUNAL_ALLOCATORS_ENABLE_TAGGING */
+    }
+
+    /// @brief   Counts an allocation against this tag.
+    /// @param   bytes The size of the allocation.
+    void
+    allocated(size_t bytes) const noexcept {
+    #if MALUNAL_ALLOCATORS_ENABLE_TAGGING
+        counters_->allocated(bytes);
+    #else
+        (void)bytes;
+    #endif /* MALUNAL_ALLOCATORS_ENABLE_TAGGING */
+    }
+
+    /// @brief   Counts a deallocation against this tag.
+    /// @param   bytes The size of the deallocation.
+    void
+    deallocated(size_t bytes) const noexcept {
+    #if MALUNAL_ALLOCATORS_ENABLE_TAGGING
+        counters_->deallocated(bytes);
+    #else
+        (void)bytes;
+    #endif /* MALUNAL_ALLOCATORS_ENABLE_TAGGING */
+    }
+
+    /// @brief   Provides the statistics of this tag.
+    /// @returns A snapshot of the statistics, empty if tagging is disabled.
+    tag_stats
+    stats() const noexcept {
+    #if MALUNAL_ALLOCATORS_ENABLE_TAGGING
+        return counters_->stats();
+    #else
+        return tag_stats{};
+    #endif /* MALUNAL_ALLOCATORS_ENABLE_TAGGING */
+    }
+
+private:
+#if MALUNAL_ALLOCATORS_ENABLE_TAGGING
+    detail::tag_counters* counters_{nullptr};
+#endif /* MALUNAL_ALLOCATORS_ENABLE_TAGGING */
+};
+
+
+/// @brief   Provides the statistics of every tag that was ever made.
+/// @details The overflow tag is included at the end if anything was counted
+///          against it. Empty if tagging is disabled.
+/// @returns A snapshot of the statistics of each tag.
+inline std::vector<tag_stats>
+tag_statistics() {
+    std::vector<tag_stats> result;
+#if MALUNAL_ALLOCATORS_ENABLE_TAGGING
+    auto& table = detail::tags();
+    for (const auto& slot : table.slots) {
+        const auto domain = slot.domain.load(std::memory_order_acquire);
+        if (domain != nullptr && domain != &detail::tag_table::k_busy)
+            result.push_back(slot.stats());
+    }
+
+    if (table.overflow.allocations.load(std::memory_order_relaxed) != 0)
+        result.push_back(table.overflow.stats());
+#endif /* MALUNAL_ALLOCATORS_ENABLE_TAGGING */
+    return result;
+}
+
+
+/// @brief   Allocates from the given memory resource and counts the allocation
+///          against the given tag.
+/// @param   resource The memory resource to allocate from.
+/// @param   bytes The amount of bytes to allocate.
+/// @param   alignment The alignment of the object to be allocated.
+/// @param   tag The tag to count the allocation against.
+/// @returns A pointer to where the data can be stored.
+/// @throws  std::bad_alloc If no memory address could be obtained.
+inline void*
+tagged_allocate(
+    std::pmr::memory_resource* resource,
+    size_t                     bytes,
+    size_t                     alignment,
+    const allocation_tag&      tag
+) {
+    auto result = resource->allocate(bytes, alignment);
+    tag.allocated(bytes);
+    return result;
+}
+
+/// @brief   Allocates from the given memory resource and counts the allocation
+///          against the source location of the caller.
+/// @param   resource The memory resource to allocate from.
+/// @param   bytes The amount of bytes to allocate.
+/// @param   alignment The alignment of the object to be allocated.
+/// @param   location The source location to count the allocation against.
+/// @returns A pointer to where the data can be stored.
+/// @throws  std::bad_alloc If no memory address could be obtained.
+/// @remarks The matching deallocation must be given the same source location,
+///          keep it as an `allocation_tag` to do so.
+inline void*
+tagged_allocate(
+    std::pmr::memory_resource* resource,
+    size_t                     bytes,
+    size_t                     alignment,
+    std::source_location       location = std::source_location::current()
+) {
+    return tagged_allocate(resource, bytes, alignment, allocation_tag(location));
+}
+
+/// @brief   Deallocates from the given memory resource and counts the
+///          deallocation against the given tag.
+/// @param   resource The memory resource to deallocate from.
+/// @param   ptr The pointer to the object to deallocate.
+/// @param   bytes The size of the object to deallocate.
+/// @param   alignment The alignment of the object to deallocate.
+/// @param   tag The tag the allocation was counted against.
+inline void
+tagged_deallocate(
+    std::pmr::memory_resource* resource,
+    void*                      ptr,
+    size_t                     bytes,
+    size_t                     alignment,
+    const allocation_tag&      tag
+) {
+    tag.deallocated(bytes);
+    resource->deallocate(ptr, bytes, alignment);
+}
+
+
+/// @brief   A tagged resource is a memory resource adapter which forwards every
+///          allocation to an upstream memory resource, and counts all of them
+///          against a single tag.
+/// @details Containers cannot pass a tag to each allocation, so give each
+///          subsystem a tagged resource over the shared arena instead:
+///
+///              tagged_resource audio(&arena, allocation_tag(subsystem::audio));
+///              std::pmr::vector<sample> samples(&audio);
+///
+///          When tagging is disabled this forwards straight to the upstream.
+struct tagged_resource : std::pmr::memory_resource {
+    using upstream = std::pmr::memory_resource;
+    using super    = std::pmr::memory_resource;
+    using self     = tagged_resource;
+
+    /// @brief   Constructs the tagged resource on top of the given upstream
+    ///          memory resource.
+    /// @param   upstream The memory resource to forward the allocations to,
+    ///          must not be `nullptr`.
+    /// @param   tag The tag to count every allocation against.
+    tagged_resource(upstream* upstream, allocation_tag tag) noexcept
+        : upstream_{ upstream }
+        , tag_{ tag }
+    {
+        assert(upstream != nullptr);
+    }
+
+    /// @brief   Constructs the tagged resource on top of the given upstream
+    ///          memory resource, tagged with the source location it is
+    ///          constructed at.
+    /// @param   upstream The memory resource to forward the allocations to,
+    ///          must not be `nullptr`.
+    /// @param   location The source location, the caller by default.
+    explicit
+    tagged_resource(
+        upstream*            upstream,
+        std::source_location location = std::source_location::current()
+    ) noexcept
+        : tagged_resource(upstream, allocation_tag(location))
+    { }
+
+    /// @brief   Provides the tag of this tagged resource.
+    /// @returns A reference to the tag.
+    const allocation_tag&
+    tag() const noexcept {
+        return tag_;
+    }
+
+    /// @brief   Provides the upstream memory resource of this tagged resource.
+    /// @returns A pointer to the upstream memory resource.
+    upstream*
+    upstream_resource() const noexcept {
+        return upstream_;
+    }
+
+protected:
+    /// @brief   Allocates from the upstream memory resource and counts the
+    ///          allocation against the tag.
+    /// @param   bytes The amount of bytes to allocate.
+    /// @param   alignment The alignment of the object to be allocated.
+    /// @returns A pointer to where the data can be stored.
+    /// @throws  std::bad_alloc If no memory address could be obtained.
+    void*
+    do_allocate(size_t bytes, size_t alignment) override {
+        return tagged_allocate(upstream_, bytes, alignment, tag_);
+    }
+
+    /// @brief   Counts the deallocation against the tag and deallocates from the
+    ///          upstream memory resource.
+    /// @param   ptr The pointer to the object to deallocate.
+    /// @param   bytes The size of the object to deallocate.
+    /// @param   alignment The alignment of the object to deallocate.
+    void
+    do_deallocate(void* ptr, size_t bytes, size_t alignment) override {
+        tagged_deallocate(upstream_, ptr, bytes, alignment, tag_);
+    }
+
+    /// @brief   Checks if the memory resource provided forwards to the same
+    ///          upstream memory resource.
+    /// @details The tag only affects the statistics, memory allocated through
+    ///          one tagged resource can be deallocated through another.
+    /// @param   other The other memory resource to compare to.
+    /// @returns True if the other memory resource is a tagged resource over the
+    ///          same upstream memory resource; false otherwise.
+    bool
+    do_is_equal(const memory_resource& other) const noexcept override {
+        auto casted = dynamic_cast<const self*>(&other);
+        return casted != nullptr && upstream_ == casted->upstream_;
+    }
+
+private:
+    upstream*      upstream_{nullptr};
+    allocation_tag tag_;
+};
+
+} // namespace malunal::allocators
@@ -0,0 +1,544 @@
+/// @file   thread_cache.hpp
+/// @brief  Provides the thread caching resource which backs the allocation
+///         shims.
+/// @author John Christman sorakatadzuma@gmail.com
+/// @copyright 2024 Malunal Studios, LLC.
+#pragma once
+
+
+// Set thread cache bin size if not yet set.
+#ifndef MALUNAL_ALLOCATORS_THREAD_CACHE_BIN_SIZE
+/// @def     MALUNAL_ALLOCATORS_THREAD_CACHE_BIN_SIZE
+/// @brief   The number of freed blocks cached per size class per thread.
+/// @details This is modifiable by you the developer. It configures how many
+///          small blocks each thread keeps around after they are freed, for
+///          each size class, so the next allocation of that size class can
+///          reuse the block without searching the free list of the arena. The
+///          lower bounds is 0, which disables the cache, and the upper bounds
+///          is 65536.
+#define MALUNAL_ALLOCATORS_THREAD_CACHE_BIN_SIZE 64
+#elif MALUNAL_ALLOCATORS_THREAD_CACHE_BIN_SIZE < 0 || \
+      MALUNAL_ALLOCATORS_THREAD_CACHE_BIN_SIZE > 65536
+#  error Thread cache bin size must be >= 0 and <= 65536
+#endif /* MALUNAL_ALLOCATORS_THREAD_CACHE_BIN_SIZE */
+
+// Set thread cache mapping threshold if not yet set.
+#ifndef MALUNAL_ALLOCATORS_THREAD_CACHE_MAPPED_THRESHOLD
+/// @def     MALUNAL_ALLOCATORS_THREAD_CACHE_MAPPED_THRESHOLD
+/// @brief   The allocation size from which the thread cache maps the memory
+///          directly from the operating system.
+/// @details This is modifiable by you the developer. Allocations of at least
+///          this many bytes bypass the arenas, so a few large blocks can't take
+///          up whole regions of an arena long after they are freed. The value
+///          must be at least a page and at most the maximum allocation size of
+///          the arena regions.
+#define MALUNAL_ALLOCATORS_THREAD_CACHE_MAPPED_THRESHOLD 0x0004'0000
+#elif MALUNAL_ALLOCATORS_THREAD_CACHE_MAPPED_THRESHOLD < 0x1000 || \
+      MALUNAL_ALLOCATORS_THREAD_CACHE_MAPPED_THRESHOLD > MALUNAL_ALLOCATORS_REGION_MAXIMUM_ALLOCATION
+#  error Thread cache mapped threshold must be >= 4096 and <= the maximum allocation size
+#endif /* MALUNAL_ALLOCATORS_THREAD_CACHE_MAPPED_THRESHOLD */
+
+
+namespace malunal::allocators {
+
+/// @brief   The number of freed blocks cached per size class per thread.
+/// @details This is controlled by a macro which you, the developer, can
+///          adjust to your needs.
+inline static constexpr size_t
+k_thread_cache_bin_size = MALUNAL_ALLOCATORS_THREAD_CACHE_BIN_SIZE;
+
+/// @brief   The allocation size from which the thread cache maps the memory
+///          directly from the operating system.
+/// @details This is controlled by a macro which you, the developer, can
+///          adjust to your needs.
+inline static constexpr size_t
+k_thread_cache_mapped_threshold = MALUNAL_ALLOCATORS_THREAD_CACHE_MAPPED_THRESHOLD;
+
+/// @brief   The alignment of every block allocated through the thread cache
+///          unless a larger one is requested, the same as `malloc`.
+inline static constexpr size_t
+k_thread_cache_alignment = alignof(std::max_align_t);
+
+} // namespace malunal::allocators
+
+
+namespace malunal::allocators::detail {
+
+/// @brief   The header stored right before every block handed out by the
+///          thread cache.
+/// @details This is what allows a block to be freed without its size, the
+///          way `free()` has to. The owner is the heap of the thread which
+///          allocated the block, or the address of the pages the block was
+///          mapped into with the lowest bit set. The length is the size of the
+///          arena allocation in bytes, or of the mapping in pages, and the
+///          offset is the distance from the start of either to the block.
+struct thread_cache_header final {
+    uintptr_t owner;
+    uint32_t  length;
+    uint32_t  offset;
+};
+
+static_assert(sizeof(thread_cache_header) == k_thread_cache_alignment);
+
+/// @brief Overlays a freed block so the bins and remote lists can link them.
+struct thread_cache_block final {
+    thread_cache_block* next;
+};
+
+/// @brief The freed blocks of a single size class cached by a heap.
+struct thread_cache_bin final {
+    thread_cache_block* head;
+    size_t              count;
+};
+
+/// @brief   The size of the largest arena allocation cached by the bins, every
+///          multiple of the alignment up to it is a size class.
+inline static constexpr size_t
+k_thread_cache_class_limit = 1024;
+
+inline static constexpr size_t
+k_thread_cache_classes = k_thread_cache_class_limit / k_thread_cache_alignment;
+
+/// @brief   The heap of a thread, the arena all of its blocks are allocated
+///          from and the bins caching the small ones once they are freed.
+/// @details Only the thread using the heap touches the arena and the bins.
+///          Blocks freed by any other thread are pushed to the remote list,
+///          which the owning thread returns to the arena the next time it
+///          allocates. When a thread exits its heap is not released, since
+///          other threads may still hold its blocks, but handed to the next
+///          thread which needs one.
+struct thread_cache_heap final {
+    arena_memory_resource                                   arena;
+    std::atomic<thread_cache_block*>                        remote{nullptr};
+    std::array<thread_cache_bin, k_thread_cache_classes>    bins{};
+    thread_cache_heap*                                      next{nullptr};
+};
+
+/// @brief   The heaps left behind by the threads which exited.
+/// @details This is constant initialized and trivially destructible, so it can
+///          be used by an allocation made before or after any constructor or
+///          destructor of the program runs.
+struct thread_cache_registry final {
+    std::atomic_flag   lock;
+    thread_cache_heap* orphans{nullptr};
+};
+
+inline thread_cache_registry&
+thread_cache_registry_instance() noexcept {
+    static thread_cache_registry
+    k_thread_cache_registry;
+    return k_thread_cache_registry;
+}
+
+/// @brief The heap of the calling thread, if it has acquired one.
+inline thread_cache_heap*&
+thread_cache_current() noexcept {
+    thread_local thread_cache_heap*
+    k_thread_cache_current = nullptr;
+    return k_thread_cache_current;
+}
+
+/// @brief   Whether the calling thread is in the middle of acquiring its heap.
+/// @details Acquiring a heap can allocate on its own, for instance to register
+///          the destructors of thread local objects. Those allocations are
+///          mapped instead of looping back into acquiring a heap.
+inline bool&
+thread_cache_acquiring() noexcept {
+    thread_local bool
+    k_thread_cache_acquiring = false;
+    return k_thread_cache_acquiring;
+}
+
+/// @brief   Whether the calling thread has already handed its heap over.
+/// @details Thread local objects destroyed after the guard can still allocate.
+///          Those allocations are mapped, since a heap acquired that late would
+///          never be handed over again.
+inline bool&
+thread_cache_exited() noexcept {
+    thread_local bool
+    k_thread_cache_exited = false;
+    return k_thread_cache_exited;
+}
+
+/// @brief Hands the heap of the calling thread over to the registry when the
+///        thread exits.
+struct thread_cache_guard final {
+    ~thread_cache_guard() noexcept {
+        thread_cache_exited() = true;
+        auto& current = thread_cache_current();
+        if (current == nullptr)
+            return;
+
+        auto& registry = thread_cache_registry_instance();
+        while (registry.lock.test_and_set(std::memory_order_acquire));
+        current->next    = registry.orphans;
+        registry.orphans = current;
+        registry.lock.clear(std::memory_order_release);
+        current = nullptr;
+    }
+};
+
+} // namespace malunal::allocators::detail
+
+
+namespace malunal::allocators {
+
+/// @brief   A memory resource which allocates from an arena owned by the
+///          calling thread, and caches the small blocks freed on it.
+/// @details Every block is preceded by a small header recording where it came
+///          from, so unlike the other resources of this library a block can be
+///          freed without knowing its size or alignment, from any thread. This
+///          is what the `malloc` and `operator new` replacements are built on.
+///
+///          Each thread acquires a heap with its own arena the first time it
+///          allocates. Small blocks freed by the thread which allocated them
+///          are cached per size class, up to `k_thread_cache_bin_size` blocks
+///          each, and reused without searching the free list of the arena.
+///          Blocks freed by another thread are handed back to the thread which
+///          allocated them. Blocks of at least `k_thread_cache_mapped_threshold`
+///          bytes are mapped directly from the operating system, and so is
+///          every block allocated by a thread after it handed its heap over
+///          on exit.
+/// @remarks No function of this resource calls `malloc` or `operator new`, so
+///          it can replace both of them.
+struct thread_cache_resource : std::pmr::memory_resource {
+    using super = std::pmr::memory_resource;
+    using self  = thread_cache_resource;
+
+    /// @brief   Allocates a block from the calling thread's heap, without
+    ///          throwing.
+    /// @param   bytes The number of bytes that need to be allocated.
+    /// @param   alignment The alignment of the block, must be a power of two.
+    /// @returns A pointer to the block, or `nullptr` if no memory could be
+    ///          obtained.
+    static void*
+    try_allocate(size_t bytes, size_t alignment = k_thread_cache_alignment) noexcept {
+        using namespace detail;
+        alignment = std::max(alignment, k_thread_cache_alignment);
+        if (bytes > k_max_bytes || alignment > k_max_alignment)
+            return nullptr;
+
+        // Aligning the block further than the header does takes this much more
+        // space at most.
+        const auto padding = alignment - k_thread_cache_alignment;
+        if (bytes + padding >= k_thread_cache_mapped_threshold)
+            return try_map(bytes, alignment);
+
+        auto heap = thread_cache_current();
+        if (heap == nullptr) {
+            if (thread_cache_acquiring() || thread_cache_exited())
+                return try_map(bytes, alignment);
+            if ((heap = acquire_heap()) == nullptr)
+                return nullptr;
+        }
+
+        if (heap->remote.load(std::memory_order_relaxed) != nullptr)
+            drain_remote(heap);
+
+        const auto length = round_up(
+            std::max(bytes, sizeof(thread_cache_block)) + sizeof(thread_cache_header) + padding,
+            k_thread_cache_alignment
+        );
+        if (padding == 0 && length <= k_thread_cache_class_limit) {
+            auto& bin = heap->bins[size_class(length)];
+            if (bin.head != nullptr) {
+                auto result = bin.head;
+                bin.head    = result->next;
+                bin.count--;
+                return result;
+            }
+        }
+
+        auto raw = heap->arena.try_allocate(length, k_thread_cache_alignment);
+        if (raw == nullptr)
+            return nullptr;
+
+        const auto base   = reinterpret_cast<uintptr_t>(raw);
+        const auto result = round_up(base + sizeof(thread_cache_header), alignment);
+        *header_of(result) = thread_cache_header {
+            .owner  = reinterpret_cast<uintptr_t>(heap),
+            .length = static_cast<uint32_t>(length),
+            .offset = static_cast<uint32_t>(result - base)
+        };
+
+        return reinterpret_cast<void*>(result);
+    }
+
+    /// @brief   Allocates a block from the calling thread's heap which is
+    ///          filled with zeros, without throwing.
+    /// @details Mapped blocks are already zeroed by the operating system, so
+    ///          only the blocks from the arena are cleared.
+    /// @param   bytes The number of bytes that need to be allocated.
+    /// @param   alignment The alignment of the block, must be a power of two.
+    /// @returns A pointer to the block, or `nullptr` if no memory could be
+    ///          obtained.
+    static void*
+    try_allocate_zeroed(size_t bytes, size_t alignment = k_thread_cache_alignment) noexcept {
+        auto result = try_allocate(bytes, alignment);
+        if (result != nullptr && !is_mapped(header_of(result)))
+            std::memset(result, 0, bytes);
+        return result;
+    }
+
+    /// @brief   Resizes a block, moving it if it can't be resized in place.
+    /// @details A block which already has room for the new size, and would not
+    ///          waste more than half of it, is kept where it is. Otherwise a new
+    ///          block is allocated with the default alignment and the contents
+    ///          are copied over.
+    /// @param   ptr The block to resize, or `nullptr` to allocate a new one.
+    /// @param   bytes The new size of the block.
+    /// @returns A pointer to the resized block, or `nullptr` if no memory could
+    ///          be obtained, in which case the original block is left intact.
+    static void*
+    try_reallocate(void* ptr, size_t bytes) noexcept {
+        if (ptr == nullptr)
+            return try_allocate(bytes);
+
+        const auto usable = usable_size(ptr);
+        if (bytes <= usable && bytes >= usable / 2)
+            return ptr;
+
+        auto result = try_allocate(bytes);
+        if (result != nullptr) {
+            std::memcpy(result, ptr, std::min(bytes, usable));
+            release(ptr);
+        }
+
+        return result;
+    }
+
+    /// @brief   Frees a block allocated by this resource, on any thread.
+    /// @param   ptr The block to free, freeing `nullptr` does nothing.
+    static void
+    release(void* ptr) noexcept {
+        using namespace detail;
+        if (ptr == nullptr)
+            return;
+
+        auto header = header_of(ptr);
+        if (is_mapped(header)) {
+            const auto length = header->length * page_resource::page_size();
+            page_resource pages;
+            pages.deallocate(
+                reinterpret_cast<void*>(header->owner & ~uintptr_t{1}),
+                length,
+                page_resource::page_size()
+            );
+
+            return;
+        }
+
+        auto heap = reinterpret_cast<thread_cache_heap*>(header->owner);
+        if (heap != thread_cache_current()) {
+            auto block  = static_cast<thread_cache_block*>(ptr);
+            block->next = heap->remote.load(std::memory_order_relaxed);
+            while (!heap->remote.compare_exchange_weak(
+                block->next,
+                block,
+                std::memory_order_release,
+                std::memory_order_relaxed
+            ));
+
+            return;
+        }
+
+        release_local(heap, header);
+    }
+
+    /// @brief   Provides the number of bytes which can be used in a block.
+    /// @details This is at least the number of bytes the block was allocated
+    ///          with, and can be more when the allocation was rounded up.
+    /// @param   ptr The block allocated by this resource.
+    /// @returns The number of usable bytes in the block.
+    static size_t
+    usable_size(const void* ptr) noexcept {
+        if (ptr == nullptr)
+            return 0;
+
+        const auto header = header_of(ptr);
+        if (is_mapped(header))
+            return header->length * page_resource::page_size() - header->offset;
+        return header->length - header->offset;
+    }
+
+protected:
+    /// @brief   Allocates a block from the calling thread's heap.
+    /// @param   bytes The number of bytes that need to be allocated.
+    /// @param   alignment The alignment of the block.
+    /// @returns A pointer to the block.
+    /// @throws  std::bad_alloc If no memory could be obtained.
+    void*
+    do_allocate(size_t bytes, size_t alignment) override {
+        auto result = try_allocate(bytes, alignment);
+        if (result == nullptr)
+            detail::throw_bad_alloc();
+        return result;
+    }
+
+    /// @brief   Frees a block allocated by this resource, the size and alignment
+    ///          are recorded in the block's header.
+    /// @param   ptr The block to free.
+    /// @param   bytes The size of the block.
+    /// @param   alignment The alignment of the block.
+    void
+    do_deallocate(void* ptr, size_t bytes, size_t alignment) override {
+        (void)bytes;
+        (void)alignment;
+        release(ptr);
+    }
+
+    /// @brief   Checks if the memory resource provided is a thread cache
+    ///          resource.
+    /// @details Every thread cache resource allocates from the same heaps, so
+    ///          blocks allocated by one can be freed by any other.
+    /// @param   other The other memory resource to compare to.
+    /// @returns True if the other memory resource is a thread cache resource.
+    bool
+    do_is_equal(const memory_resource& other) const noexcept override {
+        return dynamic_cast<const self*>(&other) != nullptr;
+    }
+
+private:
+    // Keeps the offset of a header within 32 bits, and the sizes far enough
+    // from overflowing once the header and padding are added.
+    static constexpr size_t k_max_alignment = size_t{1} << 31;
+    static constexpr size_t k_max_bytes     = SIZE_MAX / 2;
+
+    static constexpr uintptr_t
+    round_up(uintptr_t value, size_t alignment) noexcept {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    static constexpr size_t
+    size_class(size_t length) noexcept {
+        return length / k_thread_cache_alignment - 1;
+    }
+
+    static detail::thread_cache_header*
+    header_of(uintptr_t ptr) noexcept {
+        return reinterpret_cast<detail::thread_cache_header*>(ptr) - 1;
+    }
+
+    static detail::thread_cache_header*
+    header_of(const void* ptr) noexcept {
+        return header_of(reinterpret_cast<uintptr_t>(ptr));
+    }
+
+    static bool
+    is_mapped(const detail::thread_cache_header* header) noexcept {
+        return (header->owner & 1) != 0;
+    }
+
+    static void*
+    try_map(size_t bytes, size_t alignment) noexcept {
+        using namespace detail;
+        const auto page   = page_resource::page_size();
+        const auto length = round_up(bytes + sizeof(thread_cache_header) + alignment - k_thread_cache_alignment, page);
+        if (length / page > UINT32_MAX)
+            return nullptr;
+
+        page_resource pages;
+        auto raw = pages.try_allocate(length, page);
+        if (raw == nullptr)
+            return nullptr;
+
+        const auto base   = reinterpret_cast<uintptr_t>(raw);
+        const auto result = round_up(base + sizeof(thread_cache_header), alignment);
+        *header_of(result) = thread_cache_header {
+            .owner  = base | 1,
+            .length = static_cast<uint32_t>(length / page),
+            .offset = static_cast<uint32_t>(result - base)
+        };
+
+        return reinterpret_cast<void*>(result);
+    }
+
+    static void
+    release_local(detail::thread_cache_heap* heap, detail::thread_cache_header* header) noexcept {
+        using namespace detail;
+        const auto length = size_t{header->length};
+        if (header->offset == sizeof(thread_cache_header) && length <= k_thread_cache_class_limit) {
+            auto& bin = heap->bins[size_class(length)];
+            if (bin.count < k_thread_cache_bin_size) {
+                auto block  = reinterpret_cast<thread_cache_block*>(header + 1);
+                block->next = bin.head;
+                bin.head    = block;
+                bin.count++;
+                return;
+            }
+        }
+
+        const auto base = reinterpret_cast<uintptr_t>(header + 1) - header->offset;
+        heap->arena.deallocate(reinterpret_cast<void*>(base), length, k_thread_cache_alignment);
+    }
+
+    static void
+    drain_remote(detail::thread_cache_heap* heap) noexcept {
+        auto block = heap->remote.exchange(nullptr, std::memory_order_acquire);
+        while (block != nullptr) {
+            const auto next = block->next;
+            release_local(heap, header_of(block));
+            block = next;
+        }
+    }
+
+    static detail::thread_cache_heap*
+    acquire_heap() noexcept {
+        using namespace detail;
+        auto& registry = thread_cache_registry_instance();
+        while (registry.lock.test_and_set(std::memory_order_acquire));
+        auto heap = registry.orphans;
+        if (heap != nullptr)
+            registry.orphans = heap->next;
+        registry.lock.clear(std::memory_order_release);
+
+        thread_cache_acquiring() = true;
+        if (heap == nullptr)
+            heap = create_heap();
+        thread_cache_acquiring() = false;
+        if (heap == nullptr)
+            return nullptr;
+
+        // Registering the guard can allocate, which is served by the heap now
+        // that the thread has one.
+        thread_cache_current() = heap;
+        thread_local thread_cache_guard
+        k_thread_cache_guard;
+        (void)k_thread_cache_guard;
+        return heap;
+    }
+
+    static detail::thread_cache_heap*
+    create_heap() noexcept {
+        using namespace detail;
+        page_resource pages;
+        auto memory = pages.try_allocate(sizeof(thread_cache_heap), alignof(thread_cache_heap));
+        if (memory == nullptr)
+            return nullptr;
+
+    #if MALUNAL_ALLOCATORS_EXCEPTIONS
+        try {
+            return new (memory) thread_cache_heap();
+        } catch (const std::bad_alloc&) {
+            pages.deallocate(memory, sizeof(thread_cache_heap), alignof(thread_cache_heap));
+            return nullptr;
+        }
+    #else
+        return new (memory) thread_cache_heap();
+    #endif /* MALUNAL_ALLOCATORS_EXCEPTIONS */
+    }
+};
+
+
+/// @brief   Provides a default thread cache resource.
+/// @details Thread cache resources hold no state of their own, every instance
+///          allocates from the heap of the calling thread.
+/// @returns A pointer to the default thread cache resource.
+inline thread_cache_resource*
+thread_cache_instance() {
+    static thread_cache_resource
+    k_thread_cache_resource;
+    return &k_thread_cache_resource;
+}
+
+} // namespace malunal::allocators
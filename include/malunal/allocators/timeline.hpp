@@ -0,0 +1,263 @@
+/// @file   timeline.hpp
+/// @brief  Provides the arena event log exported as a Chrome trace.
+/// @author John Christman sorakatadzuma@gmail.com
+/// @copyright 2024 Malunal Studios, LLC.
+#pragma once
+
+
+namespace malunal::allocators {
+
+/// @brief   An event log which records the activity of an arena memory
+///          resource, and exports it as a Chrome `trace_event` JSON file.
+/// @details The log is fed through the allocation hooks of the arena, so it
+///          needs `MALUNAL_ALLOCATORS_ENABLE_HOOKS` to see anything. It records
+///          an instant event for every region acquisition and release, every
+///          reset and every purge, and a counter event with the used and mapped
+///          bytes of the arena at most once per counter period. Phases of your
+///          own can be marked with `begin()` and `end()`, so allocator activity
+///          can be lined up with the requests that caused it when the file is
+///          loaded into `chrome://tracing` or Perfetto:
+///
+///              arena_event_log log(arena);
+///              arena.set_hooks(log.hooks());
+///              log.begin("request");
+///              ...
+///              log.end("request");
+///              log.write("arena.json");
+///
+///          Allocations and deallocations only drive the counters, they are not
+///          recorded individually. The log is synchronized, so the arena can be
+///          shared between threads.
+struct arena_event_log {
+    using self = arena_event_log;
+
+    /// @brief   Constructs the event log for the given arena memory resource.
+    /// @details The arena is only read to sample the counters, the log must
+    ///          outlive it or have its hooks removed first.
+    /// @param   arena The arena memory resource the hooks are installed on.
+    /// @param   counter_period The shortest time between two counter events.
+    explicit
+    arena_event_log(
+        const arena_memory_resource& arena,
+        std::chrono::nanoseconds     counter_period = std::chrono::milliseconds(1)
+    ) noexcept
+        : arena_{ &arena }
+        , period_{ counter_period }
+        , last_sample_{ -counter_period.count() }
+    { }
+
+    arena_event_log(const arena_event_log& other) = delete;
+
+    arena_event_log&
+    operator=(const arena_event_log& other) = delete;
+
+    /// @brief   Provides allocation hooks which feed this event log.
+    /// @details Install these on the arena memory resource with `set_hooks()`
+    ///          or through its constructor.
+    /// @returns The allocation hooks with this event log as their context.
+    allocation_hooks
+    hooks() noexcept {
+        return allocation_hooks {
+            .context = this,
+            .on_allocate = [](void* context, void*, size_t, size_t) {
+                static_cast<self*>(context)->sample(false);
+            },
+            .on_deallocate = [](void* context, void*, size_t, size_t) {
+                static_cast<self*>(context)->sample(false);
+            },
+            .on_region_acquire = [](void* context, void* region, size_t bytes) {
+                static_cast<self*>(context)->push_usage('i', "region_acquire", region, bytes);
+            },
+            .on_region_release = [](void* context, void* region, size_t bytes) {
+                static_cast<self*>(context)->push_usage('i', "region_release", region, bytes);
+            },
+            .on_reset = [](void* context) {
+                static_cast<self*>(context)->push_usage('i', "reset", nullptr, 0);
+            },
+            .on_purge = [](void* context, size_t bytes) {
+                static_cast<self*>(context)->push_usage('i', "purge", nullptr, bytes);
+            }
+        };
+    }
+
+    /// @brief   Marks the start of a phase on the calling thread.
+    /// @param   name The name of the phase, which must outlive the event log.
+    void
+    begin(const char* name) {
+        push('B', name, nullptr, 0, 0, 0);
+    }
+
+    /// @brief   Marks the end of a phase on the calling thread.
+    /// @param   name The name of the phase, which must outlive the event log.
+    void
+    end(const char* name) {
+        push('E', name, nullptr, 0, 0, 0);
+    }
+
+    /// @brief   Records a counter event with the current usage of the arena,
+    ///          regardless of the counter period.
+    /// @remarks This reads the arena, so it must be called where the arena may
+    ///          be used, like any other call made on the arena.
+    void
+    sample() {
+        sample(true);
+    }
+
+    /// @brief   Provides the number of events recorded.
+    /// @returns The number of events.
+    size_t
+    size() const noexcept {
+        std::lock_guard lock(mutex_);
+        return events_.size();
+    }
+
+    /// @brief   Forgets every event recorded so far.
+    void
+    clear() noexcept {
+        std::lock_guard lock(mutex_);
+        events_.clear();
+    }
+
+    /// @brief   Writes the recorded events as a Chrome `trace_event` JSON file.
+    /// @param   file The file to write the events to.
+    /// @returns True if the events were written; false otherwise.
+    bool
+    write(std::FILE* file) const {
+        if (file == nullptr)
+            return false;
+
+        std::lock_guard lock(mutex_);
+        std::fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+        for (auto itr = events_.begin(); itr != events_.end(); itr++) {
+            const auto& event = *itr;
+            std::fprintf(file,
+                "%s\n{\"name\":\"%s\",\"cat\":\"arena\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":0,\"tid\":%u",
+                itr == events_.begin() ? "" : ",",
+                event.name,
+                event.phase,
+                static_cast<double>(event.timestamp) / 1000.0,
+                static_cast<unsigned>(event.thread)
+            );
+
+            if (event.phase == 'C') {
+                std::fprintf(file, ",\"args\":{\"used\":%zu,\"mapped\":%zu}}",
+                    event.used, event.mapped);
+            } else if (event.phase == 'i') {
+                std::fprintf(file, ",\"s\":\"p\",\"args\":{\"addr\":\"%#zx\",\"bytes\":%zu,\"used\":%zu,\"mapped\":%zu}}",
+                    static_cast<size_t>(event.addr), event.bytes, event.used, event.mapped);
+            } else std::fprintf(file, "}");
+        }
+
+        std::fprintf(file, "\n]}\n");
+        return std::ferror(file) == 0;
+    }
+
+    /// @brief   Writes the recorded events to the file at the given path.
+    /// @param   path The path of the file to write the events to.
+    /// @returns True if the events were written; false otherwise.
+    bool
+    write(const char* path) const {
+        auto file = std::fopen(path, "w");
+        if (file == nullptr)
+            return false;
+
+        const auto result = write(file);
+        return std::fclose(file) == 0 && result;
+    }
+
+private:
+    using clock = std::chrono::steady_clock;
+
+    /// @brief A single recorded event.
+    struct event final {
+        const char* name;
+        uint64_t    timestamp;
+        uintptr_t   addr;
+        size_t      bytes;
+        size_t      used;
+        size_t      mapped;
+        uint16_t    thread;
+        char        phase;
+    };
+
+    const arena_memory_resource* arena_{nullptr};
+    std::chrono::nanoseconds     period_;
+    clock::time_point            start_{ clock::now() };
+    std::atomic<int64_t>         last_sample_;
+    mutable std::mutex           mutex_;
+    std::vector<event>           events_;
+
+
+    static uint16_t
+    thread_index() noexcept {
+        static std::atomic<uint16_t> k_next_thread{0};
+        thread_local const uint16_t k_thread = k_next_thread++;
+        return k_thread;
+    }
+
+    int64_t
+    elapsed() const noexcept {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            clock::now() - start_
+        ).count();
+    }
+
+    void
+    sample(bool force) noexcept {
+        // Only the thread which moves the last sample forward takes the sample,
+        // every other operation within the period returns without locking.
+        const auto now = elapsed();
+        if (force) {
+            last_sample_.store(now, std::memory_order_relaxed);
+        } else {
+            auto last = last_sample_.load(std::memory_order_relaxed);
+            if (now - last < period_.count())
+                return;
+            if (!last_sample_.compare_exchange_strong(last, now, std::memory_order_relaxed))
+                return;
+        }
+
+        push_usage('C', "arena", nullptr, 0);
+    }
+
+    void
+    push_usage(char phase, const char* name, void* addr, size_t bytes) noexcept {
+        // The hooks run inside the arena, so its usage is read there, never
+        // under the log mutex by a thread which is not using the arena.
+        push(phase, name, addr, bytes, arena_->total_used(), arena_->total_size());
+    }
+
+    void
+    push(
+        char        phase,
+        const char* name,
+        void*       addr,
+        size_t      bytes,
+        size_t      used,
+        size_t      mapped
+    ) noexcept {
+        const auto timestamp = elapsed();
+
+        std::lock_guard lock(mutex_);
+    #if MALUNAL_ALLOCATORS_EXCEPTIONS
+        try {
+    #endif /* MALUNAL_ALLOCATORS_EXCEPTIONS */
+            events_.push_back(event {
+                .name      = name,
+                .timestamp = static_cast<uint64_t>(timestamp),
+                .addr      = reinterpret_cast<uintptr_t>(addr),
+                .bytes     = bytes,
+                .used      = used,
+                .mapped    = mapped,
+                .thread    = thread_index(),
+                .phase     = phase
+            });
+    #if MALUNAL_ALLOCATORS_EXCEPTIONS
+        } catch (const std::bad_alloc&) {
+            // The event is dropped, the arena must not fail because of its log.
+        }
+    #endif /* MALUNAL_ALLOCATORS_EXCEPTIONS */
+    }
+};
+
+} // namespace malunal::allocators
@@ -0,0 +1,369 @@
+/// @file   trace.hpp
+/// @brief  Provides the allocation trace recorder and replay utilities.
+/// @author John Christman sorakatadzuma@gmail.com
+/// @copyright 2024 Malunal Studios, LLC.
+#pragma once
+
+
+namespace malunal::allocators {
+
+/// @brief   The operation of a single allocation trace record.
+enum class trace_operation : uint8_t {
+    allocate,
+    deallocate
+};
+
+/// @brief   A single record of an allocation trace.
+/// @details Records are written to the trace file exactly as they are laid out
+///          here, so the structure has a fixed size of 32 bytes and no padding.
+///          Each allocation receives a unique identifier, and the record of its
+///          deallocation carries the same identifier.
+struct trace_record final {
+    /// @brief The time of the operation, in nanoseconds since the recording
+    ///        started.
+    uint64_t timestamp;
+
+    /// @brief The identifier of the allocation, starting at 0.
+    uint64_t id;
+
+    /// @brief The size of the allocation in bytes.
+    uint64_t bytes;
+
+    /// @brief The alignment of the allocation.
+    uint32_t alignment;
+
+    /// @brief The index of the thread which performed the operation.
+    uint16_t thread;
+
+    /// @brief The operation that was performed.
+    trace_operation operation;
+
+    /// @brief Reserved for future use, always 0.
+    uint8_t reserved;
+};
+
+static_assert(sizeof(trace_record) == 32, "Trace records must be 32 bytes");
+
+
+/// @brief   The header at the start of every allocation trace file.
+struct trace_header final {
+    /// @brief The magic bytes identifying an allocation trace file.
+    char magic[8];
+
+    /// @brief The version of the trace file format.
+    uint32_t version;
+
+    /// @brief The size of each record in the file.
+    uint32_t record_size;
+};
+
+/// @brief   The magic bytes at the start of every allocation trace file.
+inline static constexpr char
+k_trace_magic[8] = { 'M', 'A', 'L', 'T', 'R', 'A', 'C', 'E' };
+
+/// @brief   The version of the trace file format written by this library.
+inline static constexpr uint32_t
+k_trace_version = 1;
+
+
+/// @brief   A recording resource is a memory resource adapter which forwards
+///          every allocation to an upstream memory resource, and writes a
+///          record of every allocation and deallocation to a trace file.
+/// @details Records are buffered and written in batches with `fwrite`. The
+///          recorder is synchronized, so a single recorder can be shared by
+///          many threads as long as the upstream memory resource can be too;
+///          each thread is identified by a small index in the records.
+struct recording_resource : std::pmr::memory_resource {
+    using upstream = std::pmr::memory_resource;
+    using super    = std::pmr::memory_resource;
+    using self     = recording_resource;
+
+    /// @brief   Constructs the recording resource on top of the given upstream
+    ///          memory resource, writing to an already opened file.
+    /// @details The file is not owned by the recording resource, it is only
+    ///          flushed on destruction.
+    /// @param   upstream The memory resource to forward the allocations to.
+    /// @param   file The file to write the trace to.
+    recording_resource(upstream* upstream, std::FILE* file)
+        : upstream_{ upstream }
+        , file_{ file }
+    {
+        assert(upstream != nullptr);
+        write_header();
+
+        // The batch is flushed whenever it fills up, so it never grows past
+        // this and recording an operation never allocates the batch.
+        if (file_ != nullptr)
+            batch_.reserve(k_batch_size);
+    }
+
+    /// @brief   Constructs the recording resource on top of the given upstream
+    ///          memory resource, writing to the file at the given path.
+    /// @details The file is created, or truncated, and owned by the recording
+    ///          resource. Check `is_open()` to find out whether it could be
+    ///          opened; if it could not, nothing is recorded.
+    /// @param   upstream The memory resource to forward the allocations to.
+    /// @param   path The path of the file to write the trace to.
+    recording_resource(upstream* upstream, const char* path)
+        : recording_resource(upstream, std::fopen(path, "wb"))
+    {
+        owns_file_ = true;
+    }
+
+    recording_resource(const recording_resource& other) = delete;
+
+    recording_resource&
+    operator=(const recording_resource& other) = delete;
+
+    /// @brief   Flushes the remaining records, and closes the file if it is
+    ///          owned by this recording resource.
+    virtual
+    ~recording_resource() noexcept {
+        flush();
+        if (owns_file_ && file_ != nullptr)
+            std::fclose(file_);
+    }
+
+    /// @brief   Checks if the trace file is open.
+    /// @returns True if records are being written; false otherwise.
+    bool
+    is_open() const noexcept {
+        return file_ != nullptr;
+    }
+
+    /// @brief   Writes the buffered records to the trace file.
+    void
+    flush() noexcept {
+        std::lock_guard lock(mutex_);
+        flush_locked();
+    }
+
+    /// @brief   Provides the number of records written so far.
+    /// @returns The number of records, including those still buffered.
+    size_t
+    records() const noexcept {
+        return records_.load(std::memory_order_relaxed);
+    }
+
+protected:
+    /// @brief   Allocates from the upstream memory resource and records the
+    ///          allocation.
+    /// @details If the allocation could not be recorded, the memory is returned
+    ///          to the upstream memory resource before the exception is
+    ///          rethrown.
+    /// @param   bytes The amount of bytes to allocate.
+    /// @param   alignment The alignment of the object to be allocated.
+    /// @returns A pointer to where the data can be stored.
+    /// @throws  std::bad_alloc If no memory address could be obtained.
+    void*
+    do_allocate(size_t bytes, size_t alignment) override {
+        auto result = upstream_->allocate(bytes, alignment);
+#if MALUNAL_ALLOCATORS_EXCEPTIONS
+        try {
+            record_allocation(result, bytes, alignment);
+        } catch (...) {
+            upstream_->deallocate(result, bytes, alignment);
+            throw;
+        }
+#else
+        record_allocation(result, bytes, alignment);
+#endif /* MALUNAL_ALLOCATORS_EXCEPTIONS */
+        return result;
+    }
+
+    /// @brief   Records the deallocation and deallocates from the upstream
+    ///          memory resource.
+    /// @param   ptr The pointer to the object to deallocate.
+    /// @param   bytes The size of the object to deallocate.
+    /// @param   alignment The alignment of the object to deallocate.
+    void
+    do_deallocate(void* ptr, size_t bytes, size_t alignment) override {
+        {
+            std::lock_guard lock(mutex_);
+            auto itr = live_.find(ptr);
+            if (itr != live_.end()) {
+                push(trace_operation::deallocate, itr->second, bytes, alignment);
+                live_.erase(itr);
+            }
+        }
+
+        upstream_->deallocate(ptr, bytes, alignment);
+    }
+
+    /// @brief   Checks if the memory resource provided is this recorder.
+    /// @param   other The other memory resource to compare to.
+    /// @returns True if the other memory resource is this recorder.
+    bool
+    do_is_equal(const memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+private:
+    using clock = std::chrono::steady_clock;
+
+    inline static constexpr size_t
+    k_batch_size = 4096;
+
+    upstream*          upstream_{nullptr};
+    std::FILE*         file_{nullptr};
+    bool               owns_file_{false};
+    uint64_t           next_id_{0};
+    std::mutex         mutex_;
+    clock::time_point  start_{ clock::now() };
+
+    std::atomic<size_t>                 records_{0};
+    std::vector<trace_record>           batch_;
+    std::unordered_map<void*, uint64_t> live_;
+
+    static uint16_t
+    thread_index() noexcept {
+        static std::atomic<uint16_t> k_next_thread{0};
+        thread_local const uint16_t k_thread = k_next_thread++;
+        return k_thread;
+    }
+
+    void
+    write_header() noexcept {
+        if (file_ == nullptr)
+            return;
+
+        trace_header header{};
+        std::memcpy(header.magic, k_trace_magic, sizeof(header.magic));
+        header.version     = k_trace_version;
+        header.record_size = sizeof(trace_record);
+        std::fwrite(&header, sizeof(header), 1, file_);
+    }
+
+    void
+    record_allocation(void* ptr, size_t bytes, size_t alignment) {
+        // Only inserting into the live allocations can throw, pushing the
+        // record never reallocates the batch.
+        std::lock_guard lock(mutex_);
+        live_.emplace(ptr, next_id_);
+        push(trace_operation::allocate, next_id_++, bytes, alignment);
+    }
+
+    void
+    push(trace_operation operation, uint64_t id, size_t bytes, size_t alignment) noexcept {
+        if (file_ == nullptr)
+            return;
+
+        const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            clock::now() - start_
+        );
+
+        batch_.push_back(trace_record {
+            .timestamp = static_cast<uint64_t>(elapsed.count()),
+            .id        = id,
+            .bytes     = bytes,
+            .alignment = static_cast<uint32_t>(alignment),
+            .thread    = thread_index(),
+            .operation = operation,
+            .reserved  = 0
+        });
+
+        records_.fetch_add(1, std::memory_order_relaxed);
+        if (batch_.size() == k_batch_size)
+            flush_locked();
+    }
+
+    void
+    flush_locked() noexcept {
+        if (file_ == nullptr)
+            return;
+
+        if (!batch_.empty())
+            std::fwrite(batch_.data(), sizeof(trace_record), batch_.size(), file_);
+        batch_.clear();
+        std::fflush(file_);
+    }
+};
+
+
+/// @brief   Reads every record of an allocation trace file.
+/// @param   file The file to read the trace from, positioned at its start.
+/// @returns The records of the trace, or an empty list if the file is not an
+///          allocation trace written by a compatible version.
+inline std::vector<trace_record>
+read_trace(std::FILE* file) {
+    std::vector<trace_record> result;
+    trace_header header{};
+    if (file == nullptr || std::fread(&header, sizeof(header), 1, file) != 1)
+        return result;
+
+    if (std::memcmp(header.magic, k_trace_magic, sizeof(header.magic)) != 0 ||
+        header.version     != k_trace_version ||
+        header.record_size != sizeof(trace_record))
+        return result;
+
+    trace_record record{};
+    while (std::fread(&record, sizeof(record), 1, file) == 1)
+        result.push_back(record);
+    return result;
+}
+
+/// @brief   Reads every record of the allocation trace file at the given path.
+/// @param   path The path of the file to read the trace from.
+/// @returns The records of the trace, or an empty list if the file could not
+///          be opened or is not a compatible allocation trace.
+inline std::vector<trace_record>
+read_trace(const char* path) {
+    auto file   = std::fopen(path, "rb");
+    auto result = read_trace(file);
+    if (file != nullptr)
+        std::fclose(file);
+    return result;
+}
+
+/// @brief   Replays the given trace records against a memory resource.
+/// @details Every allocation in the trace is performed on the memory resource
+///          in the order it was recorded, and every deallocation returns the
+///          matching allocation. Records from all threads are replayed on the
+///          calling thread. Allocations still live at the end of the trace are
+///          deallocated once the replay finishes, so the memory resource is
+///          left as it was found.
+/// @param   records The records of the trace to replay.
+/// @param   resource The memory resource to replay the trace against.
+/// @returns The number of operations replayed.
+/// @throws  std::bad_alloc If the memory resource could not provide memory.
+inline size_t
+replay_trace(
+    const std::vector<trace_record>& records,
+    std::pmr::memory_resource*       resource
+) {
+    assert(resource != nullptr);
+
+    // Only the live allocations are kept, so the memory used by the replay
+    // follows the peak number of live allocations, not the length of the trace.
+    struct live final {
+        void*    ptr;
+        uint64_t bytes;
+        uint32_t alignment;
+    };
+
+    std::unordered_map<uint64_t, live> allocations;
+    for (const auto& record : records) {
+        if (record.operation == trace_operation::allocate) {
+            auto [itr, inserted] = allocations.try_emplace(
+                record.id, live{ nullptr, record.bytes, record.alignment });
+            if (!inserted)
+                continue;
+
+            itr->second.ptr = resource->allocate(record.bytes, record.alignment);
+        } else {
+            auto itr = allocations.find(record.id);
+            if (itr == allocations.end())
+                continue;
+
+            resource->deallocate(itr->second.ptr, record.bytes, record.alignment);
+            allocations.erase(itr);
+        }
+    }
+
+    for (const auto& [id, allocation] : allocations)
+        resource->deallocate(allocation.ptr, allocation.bytes, allocation.alignment);
+
+    return records.size();
+}
+
+} // namespace malunal::allocators
@@ -0,0 +1,130 @@
+/// @file   malloc.cpp
+/// @brief  Replaces the C allocation functions with the thread cache resource.
+/// @author John Christman sorakatadzuma@gmail.com
+/// @copyright 2024 Malunal Studios, LLC.
+/// @details Built into `libmalunal_malloc.so`, which either replaces `malloc`
+///          for whatever links against it, or for a whole process through
+///          `LD_PRELOAD`:
+///
+///              LD_PRELOAD=./libmalunal_malloc.so ./service
+///
+///          Besides the functions of the C standard, this replaces every
+///          function of glibc which hands out memory that is later passed to
+///          `free()`, so that none of it ends up in the wrong allocator.
+#include <cerrno>
+#include <malloc.h>
+#include <malunal/allocators.hpp>
+
+using malunal::allocators::thread_cache_resource;
+using malunal::allocators::page_resource;
+
+static bool
+is_valid_alignment(size_t alignment) noexcept {
+    return std::has_single_bit(alignment);
+}
+
+static void*
+allocate_or_set_errno(size_t bytes, size_t alignment) noexcept {
+    auto result = thread_cache_resource::try_allocate(bytes, alignment);
+    if (result == nullptr)
+        errno = ENOMEM;
+    return result;
+}
+
+
+extern "C" {
+
+void*
+malloc(size_t bytes) noexcept {
+    return allocate_or_set_errno(bytes, malunal::allocators::k_thread_cache_alignment);
+}
+
+void
+free(void* ptr) noexcept {
+    thread_cache_resource::release(ptr);
+}
+
+void*
+calloc(size_t count, size_t size) noexcept {
+    size_t bytes;
+    if (__builtin_mul_overflow(count, size, &bytes)) {
+        errno = ENOMEM;
+        return nullptr;
+    }
+
+    auto result = thread_cache_resource::try_allocate_zeroed(bytes);
+    if (result == nullptr)
+        errno = ENOMEM;
+    return result;
+}
+
+void*
+realloc(void* ptr, size_t bytes) noexcept {
+    // Like glibc, a size of zero frees the block.
+    if (ptr != nullptr && bytes == 0) {
+        thread_cache_resource::release(ptr);
+        return nullptr;
+    }
+
+    auto result = thread_cache_resource::try_reallocate(ptr, bytes);
+    if (result == nullptr)
+        errno = ENOMEM;
+    return result;
+}
+
+void*
+reallocarray(void* ptr, size_t count, size_t size) noexcept {
+    size_t bytes;
+    if (__builtin_mul_overflow(count, size, &bytes)) {
+        errno = ENOMEM;
+        return nullptr;
+    }
+
+    return realloc(ptr, bytes);
+}
+
+int
+posix_memalign(void** result, size_t alignment, size_t bytes) noexcept {
+    if (!is_valid_alignment(alignment) || alignment % sizeof(void*) != 0)
+        return EINVAL;
+
+    auto ptr = thread_cache_resource::try_allocate(bytes, alignment);
+    if (ptr == nullptr)
+        return ENOMEM;
+
+    *result = ptr;
+    return 0;
+}
+
+void*
+aligned_alloc(size_t alignment, size_t bytes) noexcept {
+    if (!is_valid_alignment(alignment)) {
+        errno = EINVAL;
+        return nullptr;
+    }
+
+    return allocate_or_set_errno(bytes, alignment);
+}
+
+void*
+memalign(size_t alignment, size_t bytes) noexcept {
+    return aligned_alloc(alignment, bytes);
+}
+
+void*
+valloc(size_t bytes) noexcept {
+    return allocate_or_set_errno(bytes, page_resource::page_size());
+}
+
+void*
+pvalloc(size_t bytes) noexcept {
+    const auto pagem1 = page_resource::page_size() - 1;
+    return allocate_or_set_errno((bytes + pagem1) & ~pagem1, pagem1 + 1);
+}
+
+size_t
+malloc_usable_size(void* ptr) noexcept {
+    return thread_cache_resource::usable_size(ptr);
+}
+
+} // extern "C"
@@ -0,0 +1,152 @@
+/// @file   new.cpp
+/// @brief  Replaces the global `operator new` and `operator delete` with the
+///         thread cache resource.
+/// @author John Christman sorakatadzuma@gmail.com
+/// @copyright 2024 Malunal Studios, LLC.
+/// @details Built into the `malunal_new` object library. Linking it into an
+///          executable replaces every replaceable allocation function of the
+///          program, so containers and dependencies which don't know about
+///          `std::pmr` allocate from the thread cached arenas as well:
+///
+///              target_link_libraries(service PRIVATE malunal_new)
+///
+///          The sizes and alignments passed to the sized and aligned delete
+///          overloads aren't needed, since every block records them in its
+///          header. That is also what lets a block allocated on one thread be
+///          deleted on another.
+#include <new>
+#include <malunal/allocators.hpp>
+
+using malunal::allocators::thread_cache_resource;
+using malunal::allocators::k_thread_cache_alignment;
+
+// Calls the new handler until the allocation succeeds, as the standard requires
+// of the throwing allocation functions.
+static void*
+allocate_or_throw(size_t bytes, size_t alignment) {
+    while (true) {
+        auto result = thread_cache_resource::try_allocate(bytes, alignment);
+        if (result != nullptr)
+            return result;
+
+        auto handler = std::get_new_handler();
+        if (handler == nullptr)
+            malunal::allocators::detail::throw_bad_alloc();
+        handler();
+    }
+}
+
+static void*
+allocate_or_null(size_t bytes, size_t alignment) noexcept {
+#if MALUNAL_ALLOCATORS_EXCEPTIONS
+    try {
+        return allocate_or_throw(bytes, alignment);
+    } catch (const std::bad_alloc&) {
+        return nullptr;
+    }
+#else
+    return thread_cache_resource::try_allocate(bytes, alignment);
+#endif /* MALUNAL_ALLOCATORS_EXCEPTIONS */
+}
+
+
+void*
+operator new(size_t bytes) {
+    return allocate_or_throw(bytes, k_thread_cache_alignment);
+}
+
+void*
+operator new[](size_t bytes) {
+    return allocate_or_throw(bytes, k_thread_cache_alignment);
+}
+
+void*
+operator new(size_t bytes, std::align_val_t alignment) {
+    return allocate_or_throw(bytes, static_cast<size_t>(alignment));
+}
+
+void*
+operator new[](size_t bytes, std::align_val_t alignment) {
+    return allocate_or_throw(bytes, static_cast<size_t>(alignment));
+}
+
+void*
+operator new(size_t bytes, const std::nothrow_t&) noexcept {
+    return allocate_or_null(bytes, k_thread_cache_alignment);
+}
+
+void*
+operator new[](size_t bytes, const std::nothrow_t&) noexcept {
+    return allocate_or_null(bytes, k_thread_cache_alignment);
+}
+
+void*
+operator new(size_t bytes, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return allocate_or_null(bytes, static_cast<size_t>(alignment));
+}
+
+void*
+operator new[](size_t bytes, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return allocate_or_null(bytes, static_cast<size_t>(alignment));
+}
+
+
+void
+operator delete(void* ptr) noexcept {
+    thread_cache_resource::release(ptr);
+}
+
+void
+operator delete[](void* ptr) noexcept {
+    thread_cache_resource::release(ptr);
+}
+
+void
+operator delete(void* ptr, size_t) noexcept {
+    thread_cache_resource::release(ptr);
+}
+
+void
+operator delete[](void* ptr, size_t) noexcept {
+    thread_cache_resource::release(ptr);
+}
+
+void
+operator delete(void* ptr, std::align_val_t) noexcept {
+    thread_cache_resource::release(ptr);
+}
+
+void
+operator delete[](void* ptr, std::align_val_t) noexcept {
+    thread_cache_resource::release(ptr);
+}
+
+void
+operator delete(void* ptr, size_t, std::align_val_t) noexcept {
+    thread_cache_resource::release(ptr);
+}
+
+void
+operator delete[](void* ptr, size_t, std::align_val_t) noexcept {
+    thread_cache_resource::release(ptr);
+}
+
+void
+operator delete(void* ptr, const std::nothrow_t&) noexcept {
+    thread_cache_resource::release(ptr);
+}
+
+void
+operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+    thread_cache_resource::release(ptr);
+}
+
+void
+operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept {
+    thread_cache_resource::release(ptr);
+}
+
+void
+operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept {
+    thread_cache_resource::release(ptr);
+}
@@ -81,3 +81,218 @@ TEST(ArenaMemoryTests, can_deallocate_memory) {
     ASSERT_EQ(space, node.size);
     ASSERT_EQ(addr,  node.addr);
 }
+
+TEST(ArenaMemoryTests, can_try_allocate_memory) {
+    test_arena_memory_resource mem;
+    ASSERT_EQ(nullptr, mem.try_allocate(k_max_alloc_size + 1, alignof(int)));
+    ASSERT_EQ(1, mem.allocations());
+
+    auto res = mem.try_allocate(sizeof(int), alignof(int));
+    ASSERT_NE(nullptr, res);
+    ASSERT_EQ(2, mem.allocations());
+    ASSERT_THROW((void)mem.allocate(k_max_alloc_size + 1, alignof(int)), std::bad_alloc);
+}
+
+TEST(ArenaMemoryTests, can_grow_regions) {
+    test_arena_memory_resource mem;
+    auto first  = mem.allocate(k_max_alloc_size / 2, alignof(int));
+    auto second = mem.allocate(k_max_alloc_size / 2 + 1024, alignof(int));
+    ASSERT_NE(nullptr, first);
+    ASSERT_NE(nullptr, second);
+    ASSERT_EQ(2, mem.total_regions());
+    ASSERT_EQ(0x0080'0000, mem.total_size());
+    ASSERT_TRUE(mem.owns(second));
+}
+
+TEST(ArenaMemoryTests, can_report_statistics) {
+    test_arena_memory_resource mem;
+    auto small = mem.allocate(16, alignof(int));
+    auto large = mem.allocate(1000, alignof(int));
+    mem.deallocate(small, 16, alignof(int));
+
+    const auto stats = mem.stats();
+    ASSERT_EQ(mem.total_used(), stats.total_used);
+    ASSERT_EQ(mem.total_size(), stats.total_size);
+    ASSERT_EQ(mem.allocations(), stats.allocations);
+    ASSERT_EQ(520 + 16 + 1000, stats.peak_used);
+    ASSERT_EQ(mem.free_list().size(), stats.free_blocks);
+    ASSERT_EQ(0, stats.region_growths);
+    ASSERT_EQ(0, stats.live_blocks[arena_stats::size_class(16)]);
+    ASSERT_EQ(1, stats.live_blocks[arena_stats::size_class(1000)]);
+    ASSERT_EQ(1, stats.free_block_sizes[arena_stats::size_class(16)]);
+    ASSERT_EQ(0x0040'0000 - 520 - 16 - 1000, stats.largest_free_block);
+    ASSERT_EQ(stats.largest_free_block + 16, stats.free_bytes);
+    ASSERT_GT(stats.fragmentation, 0.0);
+    ASSERT_LT(stats.fragmentation, 0.01);
+
+    mem.deallocate(large, 1000, alignof(int));
+}
+
+TEST(ArenaMemoryTests, can_grow_free_list) {
+    test_arena_memory_resource mem;
+    std::vector<void*> blocks;
+    for (size_t index = 0; index < k_free_list_size * 4; index++)
+        blocks.push_back(mem.allocate(64, alignof(int)));
+
+    // Every other block is freed so no two free blocks can coalesce.
+    for (size_t index = 0; index < blocks.size(); index += 2)
+        mem.deallocate(blocks[index], 64, alignof(int));
+
+    ASSERT_LT(k_free_list_size, mem.free_list().size());
+    auto result = mem.allocate(64, alignof(int));
+    auto freed  = std::find(blocks.begin(), blocks.end(), result);
+    ASSERT_NE(blocks.end(), freed);
+    ASSERT_EQ(0, (freed - blocks.begin()) % 2);
+}
+
+TEST(ArenaMemoryTests, can_coalesce_free_blocks) {
+    test_arena_memory_resource mem;
+    const auto baseline = mem.total_used();
+    std::vector<void*> blocks;
+    for (size_t index = 0; index < k_free_list_size * 4; index++)
+        blocks.push_back(mem.allocate(16 + (index % 8) * 16, alignof(int)));
+
+    // Freed in allocation order, every block merges with the one before it.
+    for (size_t index = 0; index < blocks.size(); index++)
+        mem.deallocate(blocks[index], 16 + (index % 8) * 16, alignof(int));
+
+    const auto  reg  = reinterpret_cast<uintptr_t>(mem.first_region());
+    const auto  frd  = mem.free_list();
+    const auto& node = frd[0];
+    ASSERT_EQ(1, frd.size());
+    ASSERT_EQ(baseline, mem.total_used());
+    ASSERT_EQ(reg + baseline, node.addr);
+    ASSERT_EQ(0x0040'0000 - baseline, node.size);
+}
+
+TEST(ArenaMemoryTests, can_return_alignment_padding) {
+    test_arena_memory_resource mem;
+    const auto baseline = mem.total_used();
+
+    // Both the padding recorded in front of over-aligned blocks and the few
+    // bytes skipped to align an `int` have to be given back.
+    auto small  = mem.allocate(1, 1);
+    auto number = mem.allocate(sizeof(int), alignof(int));
+    auto first  = mem.allocate(24, 64);
+    auto second = mem.allocate(40, 64);
+    ASSERT_EQ(0, reinterpret_cast<uintptr_t>(first) % 64);
+    ASSERT_EQ(0, reinterpret_cast<uintptr_t>(second) % 64);
+    mem.deallocate(second, 40, 64);
+    mem.deallocate(small, 1, 1);
+    mem.deallocate(first, 24, 64);
+    mem.deallocate(number, sizeof(int), alignof(int));
+
+    const auto reg = reinterpret_cast<uintptr_t>(mem.first_region());
+    const auto frd = mem.free_list();
+    ASSERT_EQ(1, frd.size());
+    ASSERT_EQ(baseline, mem.total_used());
+    ASSERT_EQ(reg + baseline, frd[0].addr);
+    ASSERT_EQ(0x0040'0000 - baseline, frd[0].size);
+}
+
+TEST(ArenaMemoryTests, can_churn_over_aligned_blocks) {
+    test_arena_memory_resource mem;
+    const auto baseline = mem.total_used();
+    std::vector<void*> blocks;
+    for (size_t index = 0; index < k_free_list_size * 8; index++)
+        blocks.push_back(mem.allocate(8, 64));
+
+    // The padding of live blocks is never left on the free list, so replacing
+    // every other block over and over keeps the free list at one block.
+    ASSERT_EQ(1, mem.free_list().size());
+    for (size_t round = 0; round < 64; round++) {
+        for (size_t index = round % 2; index < blocks.size(); index += 2) {
+            mem.deallocate(blocks[index], 8, 64);
+            blocks[index] = mem.allocate(8, 64);
+            ASSERT_EQ(0, reinterpret_cast<uintptr_t>(blocks[index]) % 64);
+        }
+
+        ASSERT_EQ(1, mem.free_list().size());
+    }
+
+    for (const auto block : blocks)
+        mem.deallocate(block, 8, 64);
+    ASSERT_EQ(1, mem.free_list().size());
+    ASSERT_EQ(baseline, mem.total_used());
+}
+
+TEST(ArenaMemoryTests, can_walk_regions) {
+    test_arena_memory_resource mem;
+    auto first  = mem.allocate(64, alignof(int));
+    auto second = mem.allocate(128, alignof(int));
+    auto third  = mem.allocate(k_max_alloc_size, alignof(int));
+    mem.deallocate(first, 64, alignof(int));
+    (void)second;
+    (void)third;
+
+    size_t total = 0;
+    size_t free  = 0;
+    size_t used  = 0;
+    size_t regions = 0;
+    uintptr_t next = 0;
+    mem.walk([&](const arena_span& span) {
+        if (span.kind == arena_span_kind::metadata) {
+            regions++;
+        } else ASSERT_EQ(next, span.addr);
+
+        next   = span.addr + span.size;
+        total += span.size;
+        (span.kind == arena_span_kind::free ? free : used) += span.size;
+    });
+
+    const auto stats = mem.stats();
+    ASSERT_EQ(stats.total_regions, regions);
+    ASSERT_EQ(stats.total_size, total);
+    ASSERT_EQ(stats.free_bytes, free);
+    ASSERT_EQ(stats.total_used, used);
+
+    auto file = std::tmpfile();
+    ASSERT_NE(nullptr, file);
+    ASSERT_TRUE(write_occupancy_map(mem, file));
+
+    std::rewind(file);
+    char buffer[256]{};
+    ASSERT_NE(nullptr, std::fgets(buffer, sizeof(buffer), file));
+    std::fclose(file);
+    ASSERT_EQ(0, std::strncmp(buffer, "{\"regions\":[{\"index\":0,", 23));
+}
+
+TEST(ArenaMemoryTests, can_purge_free_pages) {
+    test_arena_memory_resource mem;
+    auto ptr = static_cast<char*>(mem.allocate(0x10'0000, alignof(int)));
+    std::memset(ptr, 0xA5, 0x10'0000);
+    mem.deallocate(ptr, 0x10'0000, alignof(int));
+
+    // Everything but the partial pages at the edges of the free space.
+    const auto purged = mem.purge();
+    ASSERT_LT(k_max_alloc_size - 0x2000, purged);
+    ASSERT_EQ(0, purged % page_resource::page_size());
+
+    // Purged pages read back as zero and can be allocated again.
+    auto again = static_cast<char*>(mem.allocate(0x10'0000, alignof(int)));
+    ASSERT_EQ(0, again[0x8000]);
+}
+
+TEST(ArenaMemoryTests, can_report_memory_usage) {
+    test_arena_memory_resource mem;
+    auto ptr = static_cast<char*>(mem.allocate(0x10'0000, alignof(int)));
+    std::memset(ptr, 0xA5, 0x10'0000);
+
+    const auto touched = mem.memory_usage();
+    ASSERT_EQ(mem.total_size(), touched.reserved);
+    ASSERT_EQ(mem.total_size(), touched.committed);
+    ASSERT_LE(0x10'0000, touched.resident);
+    ASSERT_GE(touched.committed, touched.resident);
+
+    mem.deallocate(ptr, 0x10'0000, alignof(int));
+    const auto purged = mem.purge();
+    const auto usage  = mem.memory_usage();
+    ASSERT_EQ(purged, usage.purged_bytes);
+    ASSERT_EQ(purged / page_resource::page_size(), usage.purged_pages);
+    ASSERT_GT(touched.resident, usage.resident);
+    ASSERT_EQ(0, mem.memory_usage(false).resident);
+
+    // Purging again reports that purge alone, not the sum of both.
+    ASSERT_EQ(purged, mem.purge());
+    ASSERT_EQ(purged, mem.memory_usage(false).purged_bytes);
+}
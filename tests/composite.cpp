@@ -0,0 +1,58 @@
+#include <gtest/gtest.h>
+#include <malunal/allocators.hpp>
+
+using namespace malunal::allocators;
+
+
+TEST(CompositeTests, fallback_prefers_primary) {
+    alignas(16) std::byte  buffer[64];
+    linear_buffer_resource linear(buffer, sizeof(buffer));
+    arena_memory_resource  arena;
+    fallback_resource      composed(&linear, &arena);
+
+    auto first = composed.allocate(32, 8);
+    ASSERT_TRUE(linear.owns(first));
+    ASSERT_EQ(1, arena.allocations()); // Free list counts as an allocation.
+
+    auto second = composed.allocate(64, 8);
+    ASSERT_FALSE(linear.owns(second));
+    ASSERT_TRUE(arena.owns(second));
+    ASSERT_EQ(2, arena.allocations());
+
+    composed.deallocate(second, 64, 8);
+    composed.deallocate(first, 32, 8);
+    ASSERT_EQ(1, arena.allocations());
+}
+
+TEST(CompositeTests, segregator_routes_by_size) {
+    arena_memory_resource arena;
+    node_pool_resource    pool(&arena);
+    segregator_resource<k_node_max_size> composed(&pool, &arena);
+
+    auto small = composed.allocate(24, 8);
+    ASSERT_TRUE(pool.owns(small));
+    ASSERT_TRUE(composed.owns(small));
+
+    auto large = composed.allocate(k_node_max_size + 8, 8);
+    ASSERT_FALSE(pool.owns(large));
+    ASSERT_TRUE(composed.owns(large));
+
+    const auto allocations = arena.allocations();
+    composed.deallocate(large, k_node_max_size + 8, 8);
+    composed.deallocate(small, 24, 8);
+    ASSERT_EQ(allocations - 1, arena.allocations());
+}
+
+TEST(CompositeTests, composes_with_containers) {
+    alignas(16) std::byte  buffer[256];
+    linear_buffer_resource linear(buffer, sizeof(buffer));
+    arena_memory_resource  arena;
+    fallback_resource      composed(&linear, &arena);
+
+    std::pmr::vector<int> vec(&composed);
+    for (auto index = 0; index < 256; index++)
+        vec.push_back(index);
+
+    ASSERT_TRUE(arena.owns(vec.data()));
+    ASSERT_EQ(255, vec.back());
+}
@@ -0,0 +1,176 @@
+#include <coroutine>
+#include <thread>
+#include <gtest/gtest.h>
+#include <malunal/allocators.hpp>
+
+using namespace malunal::allocators;
+
+
+/// Every test uses its own promise type, so the frames cached by one test are
+/// never handed to another regardless of the order the tests run in.
+template<int Id>
+struct test_task final {
+    struct promise_type : coroutine_frame_allocator<promise_type> {
+        int value{0};
+
+        test_task
+        get_return_object() noexcept {
+            return test_task(handle::from_promise(*this));
+        }
+
+        std::suspend_always
+        initial_suspend() const noexcept {
+            return {};
+        }
+
+        std::suspend_always
+        final_suspend() const noexcept {
+            return {};
+        }
+
+        void
+        return_value(int result) noexcept {
+            value = result;
+        }
+
+        void
+        unhandled_exception() const noexcept {
+            std::terminate();
+        }
+    };
+
+    using handle = std::coroutine_handle<promise_type>;
+
+    explicit
+    test_task(handle coro) noexcept
+        : coro_{ coro }
+    { }
+
+    test_task(test_task&& other) noexcept
+        : coro_{ std::exchange(other.coro_, nullptr) }
+    { }
+
+    ~test_task() noexcept {
+        if (coro_)
+            coro_.destroy();
+    }
+
+    int
+    run() {
+        coro_.resume();
+        return coro_.promise().value;
+    }
+
+    const void*
+    frame() const noexcept {
+        return coro_.address();
+    }
+
+private:
+    handle coro_;
+};
+
+template<int Id>
+static test_task<Id>
+add_values(int lhs, int rhs) {
+    co_return lhs + rhs;
+}
+
+template<int Id>
+static test_task<Id>
+sum_values(int count) {
+    int values[64]{};
+    for (int index = 0; index < count; index++)
+        values[index] = index;
+
+    co_await std::suspend_never{};
+    int total = 0;
+    for (int index = 0; index < count; index++)
+        total += values[index];
+    co_return total;
+}
+
+// Holds on to every cached frame of the promise type, so the frames created
+// afterwards come from the arena even when the test is repeated.
+template<int Id>
+static std::vector<test_task<Id>>
+drain_frame_cache() {
+    const auto arena = thread_arena_instance();
+    std::vector<test_task<Id>> result;
+    for (;;) {
+        const auto before = arena->allocations();
+        result.push_back(add_values<Id>(0, 0));
+        if (arena->allocations() != before)
+            return result;
+    }
+}
+
+
+TEST(CoroutineFrameTests, allocates_frames_from_thread_arena) {
+    const auto drained = drain_frame_cache<0>();
+    const auto arena   = thread_arena_instance();
+    const auto before  = arena->allocations();
+
+    auto first  = add_values<0>(1, 2);
+    auto second = add_values<0>(3, 4);
+    ASSERT_EQ(3, first.run());
+    ASSERT_EQ(7, second.run());
+    ASSERT_EQ(before + 2, arena->allocations());
+    ASSERT_EQ(0, reinterpret_cast<uintptr_t>(first.frame()) % k_frame_alignment);
+}
+
+TEST(CoroutineFrameTests, reuses_cached_frames) {
+    const void* frame = nullptr;
+    {
+        auto task = add_values<1>(1, 2);
+        frame = task.frame();
+    }
+
+    const auto arena  = thread_arena_instance();
+    const auto before = arena->allocations();
+
+    auto task = add_values<1>(5, 6);
+    ASSERT_EQ(frame, task.frame());
+    ASSERT_EQ(before, arena->allocations());
+    ASSERT_EQ(11, task.run());
+}
+
+TEST(CoroutineFrameTests, caches_frames_per_frame_size) {
+    const void* small = nullptr;
+    const void* large = nullptr;
+    {
+        auto first  = add_values<2>(1, 2);
+        auto second = sum_values<2>(4);
+        small = first.frame();
+        large = second.frame();
+    }
+
+    const auto arena  = thread_arena_instance();
+    const auto before = arena->allocations();
+
+    auto first  = add_values<2>(5, 6);
+    auto second = sum_values<2>(4);
+    ASSERT_EQ(small, first.frame());
+    ASSERT_EQ(large, second.frame());
+    ASSERT_EQ(before, arena->allocations());
+    ASSERT_EQ(11, first.run());
+    ASSERT_EQ(6, second.run());
+}
+
+TEST(CoroutineFrameTests, returns_frames_destroyed_on_other_threads) {
+    const auto drained = drain_frame_cache<3>();
+    const auto arena   = thread_arena_instance();
+    const auto before  = arena->allocations();
+
+    auto task = add_values<3>(1, 2);
+    ASSERT_EQ(before + 1, arena->allocations());
+    std::thread([moved = std::move(task)]() mutable {
+        ASSERT_EQ(3, moved.run());
+    }).join();
+
+    // The frame is handed back on the next allocation of the owning thread.
+    ASSERT_EQ(before + 1, arena->allocations());
+    auto other = add_values<3>(5, 6);
+    ASSERT_EQ(before + 1, arena->allocations());
+    ASSERT_EQ(11, other.run());
+}
@@ -0,0 +1,62 @@
+#include <gtest/gtest.h>
+#include <malunal/allocators.hpp>
+
+using namespace malunal::allocators;
+
+
+struct hook_counts final {
+    size_t allocations{0};
+    size_t deallocations{0};
+    size_t acquired{0};
+    size_t released{0};
+    size_t bytes{0};
+};
+
+static allocation_hooks
+make_counting_hooks(hook_counts& counts) {
+    return allocation_hooks {
+        .context = &counts,
+        .on_allocate = [](void* context, void*, size_t bytes, size_t) {
+            static_cast<hook_counts*>(context)->allocations++;
+            static_cast<hook_counts*>(context)->bytes += bytes;
+        },
+        .on_deallocate = [](void* context, void*, size_t bytes, size_t) {
+            static_cast<hook_counts*>(context)->deallocations++;
+            static_cast<hook_counts*>(context)->bytes -= bytes;
+        },
+        .on_region_acquire = [](void* context, void*, size_t) {
+            static_cast<hook_counts*>(context)->acquired++;
+        },
+        .on_region_release = [](void* context, void*, size_t) {
+            static_cast<hook_counts*>(context)->released++;
+        }
+    };
+}
+
+
+TEST(AllocationHookTests, reports_allocations) {
+    hook_counts counts;
+    arena_memory_resource arena;
+    arena.set_hooks(make_counting_hooks(counts));
+
+    auto ptr = arena.allocate(64, 8);
+    ASSERT_EQ(1, counts.allocations);
+    ASSERT_EQ(64, counts.bytes);
+
+    arena.deallocate(ptr, 64, 8);
+    ASSERT_EQ(1, counts.deallocations);
+    ASSERT_EQ(0, counts.bytes);
+}
+
+TEST(AllocationHookTests, reports_regions) {
+    hook_counts counts;
+    {
+        arena_memory_resource arena(make_counting_hooks(counts));
+        ASSERT_EQ(1, counts.acquired);
+
+        (void)arena.allocate(k_max_alloc_size, 8);
+        ASSERT_EQ(2, counts.acquired);
+    }
+
+    ASSERT_EQ(2, counts.released);
+}
@@ -0,0 +1,57 @@
+#include <gtest/gtest.h>
+#include <malunal/allocators.hpp>
+
+using namespace malunal::allocators;
+
+
+TEST(LatencyHistogramTests, buckets_are_log_linear) {
+    for (uint64_t value = 0; value < 8; value++) {
+        ASSERT_EQ(value, latency_histogram::bucket_index(value));
+        ASSERT_EQ(value, latency_histogram::bucket_upper(value));
+    }
+
+    // Every value falls into a bucket no wider than an eighth of it.
+    for (uint64_t value = 8; value < 0x1'0000; value += 7) {
+        const auto index = latency_histogram::bucket_index(value);
+        const auto upper = latency_histogram::bucket_upper(index);
+        ASSERT_LE(value, upper);
+        ASSERT_LE(upper - value, value / 8);
+    }
+
+    ASSERT_EQ(latency_histogram::k_buckets - 1, latency_histogram::bucket_index(UINT64_MAX));
+    ASSERT_EQ(UINT64_MAX, latency_histogram::bucket_upper(latency_histogram::k_buckets - 1));
+}
+
+TEST(LatencyHistogramTests, reports_percentiles) {
+    latency_histogram histogram;
+    for (uint64_t value = 1; value <= 1000; value++)
+        histogram.record(value);
+    histogram.record(1'000'000);
+
+    const auto summary = histogram.summary();
+    ASSERT_EQ(1001, summary.count);
+    ASSERT_LE(500, summary.p50);
+    ASSERT_GE(500 + 500 / 8, summary.p50);
+    ASSERT_LE(990, summary.p99);
+    ASSERT_GE(1000 + 1000 / 8, summary.p99);
+    ASSERT_EQ(1'000'000, summary.max);
+
+    histogram.reset();
+    ASSERT_EQ(0, histogram.summary().count);
+    ASSERT_EQ(0, histogram.summary().p50);
+}
+
+TEST(LatencyHistogramTests, times_operations) {
+    arena_memory_resource arena;
+    timed_resource resource(&arena);
+    for (auto index = 0; index < 100; index++) {
+        auto ptr = resource.allocate(64, 8);
+        resource.deallocate(ptr, 64, 8);
+    }
+
+    const auto stats = resource.stats();
+    ASSERT_EQ(100, stats.allocate.count);
+    ASSERT_EQ(100, stats.deallocate.count);
+    ASSERT_LE(stats.allocate.p50, stats.allocate.p99);
+    ASSERT_LE(stats.allocate.p99, stats.allocate.max);
+}
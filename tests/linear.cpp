@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+#include <malunal/allocators.hpp>
+
+using namespace malunal::allocators;
+
+
+TEST(LinearBufferTests, try_allocate_aligns_and_fills) {
+    alignas(16) std::byte  buffer[64];
+    linear_buffer_resource linear(buffer, sizeof(buffer));
+
+    auto first  = linear.try_allocate(1, 1);
+    auto second = linear.try_allocate(8, 8);
+    ASSERT_EQ(buffer, first);
+    ASSERT_EQ(buffer + 8, second); // Padded to the alignment.
+
+    ASSERT_NE(nullptr, linear.try_allocate(48, 8));
+    ASSERT_EQ(nullptr, linear.try_allocate(1, 1));
+}
+
+TEST(LinearBufferTests, allocate_throws_when_full) {
+    alignas(16) std::byte  buffer[16];
+    linear_buffer_resource linear(buffer, sizeof(buffer));
+
+    ASSERT_NO_THROW((void)linear.allocate(16, 8));
+    ASSERT_THROW((void)linear.allocate(1, 1), std::bad_alloc);
+
+    linear.reset();
+    ASSERT_EQ(buffer, linear.try_allocate(16, 8));
+}
+
+TEST(LinearBufferTests, lifo_reclaims_most_recent) {
+    alignas(16) std::byte  buffer[64];
+    linear_buffer_resource linear(buffer, sizeof(buffer), linear_mode::lifo);
+
+    auto first  = linear.allocate(16, 8);
+    auto second = linear.allocate(16, 8);
+    linear.deallocate(second, 16, 8);
+    ASSERT_EQ(second, linear.allocate(32, 8));
+    ASSERT_EQ(nullptr, linear.try_allocate(32, 8));
+
+    linear.deallocate(first, 16, 8); // Not the most recent, remembered.
+    linear.deallocate(second, 32, 8);
+    ASSERT_EQ(first, linear.allocate(64, 8));
+}
+
+TEST(LinearBufferTests, lifo_reclaims_temporary_vectors) {
+    alignas(16) std::byte  buffer[256];
+    linear_buffer_resource linear(buffer, sizeof(buffer), linear_mode::lifo);
+
+    for (auto round = 0; round < 16; round++) {
+        std::pmr::vector<int> temp(&linear);
+        temp.reserve(16);
+        for (auto index = 0; index < 16; index++)
+            temp.push_back(index);
+    }
+
+    ASSERT_EQ(buffer, linear.try_allocate(256, 8));
+}
+
+TEST(LinearBufferTests, lifo_reclaims_growing_vectors) {
+    alignas(16) std::byte  buffer[256];
+    linear_buffer_resource linear(buffer, sizeof(buffer), linear_mode::lifo);
+
+    for (auto round = 0; round < 16; round++) {
+        std::pmr::vector<int> temp(&linear);
+        for (auto index = 0; index < 16; index++)
+            temp.push_back(index);
+    }
+
+    ASSERT_EQ(buffer, linear.try_allocate(256, 8));
+}
+
+TEST(LinearBufferTests, lifo_keeps_blocks_below_live_ones) {
+    alignas(16) std::byte  buffer[64];
+    linear_buffer_resource linear(buffer, sizeof(buffer), linear_mode::lifo);
+
+    auto first  = linear.allocate(16, 8);
+    auto second = linear.allocate(16, 8);
+    auto third  = linear.allocate(16, 8);
+    linear.deallocate(first, 16, 8);
+    linear.deallocate(third, 16, 8); // The second block is still alive.
+    ASSERT_EQ(third, linear.allocate(16, 8));
+
+    linear.deallocate(third, 16, 8);
+    linear.deallocate(second, 16, 8);
+    ASSERT_EQ(buffer, linear.try_allocate(64, 8));
+}
@@ -0,0 +1,70 @@
+#include <thread>
+#include <gtest/gtest.h>
+#include <malunal/allocators.hpp>
+
+using namespace malunal::allocators;
+
+
+TEST(OperatorNewTests, can_allocate_from_thread_cache) {
+    auto res = ::operator new(48);
+    ::operator delete(res, 48);
+
+    // Only the thread cache can hand the freed block out again.
+    auto same = thread_cache_resource::try_allocate(48);
+    ASSERT_EQ(res, same);
+    thread_cache_resource::release(same);
+}
+
+TEST(OperatorNewTests, can_allocate_arrays) {
+    auto res = new int[100]{};
+    ASSERT_LE(100 * sizeof(int), thread_cache_resource::usable_size(res));
+    ASSERT_EQ(0, res[99]);
+    delete[] res;
+}
+
+TEST(OperatorNewTests, can_allocate_aligned_memory) {
+    struct alignas(256) aligned final {
+        char data[256];
+    };
+
+    auto res = new aligned;
+    ASSERT_EQ(0, reinterpret_cast<uintptr_t>(res) % alignof(aligned));
+    delete res;
+
+    auto arr = new (std::nothrow) aligned[4];
+    ASSERT_NE(nullptr, arr);
+    ASSERT_EQ(0, reinterpret_cast<uintptr_t>(arr) % alignof(aligned));
+    delete[] arr;
+}
+
+TEST(OperatorNewTests, can_fail_allocation) {
+    const auto bytes = size_t{1} << 62; // More than can ever be mapped.
+    ASSERT_EQ(nullptr, ::operator new(bytes, std::nothrow));
+    ASSERT_THROW(::operator delete(::operator new(bytes)), std::bad_alloc);
+}
+
+TEST(OperatorNewTests, can_call_new_handler) {
+    static size_t calls = 0;
+    calls = 0;
+    auto previous = std::set_new_handler([] {
+        if (++calls == 2)
+            std::set_new_handler(nullptr);
+    });
+
+    const auto bytes = size_t{1} << 62;
+    ASSERT_THROW(::operator delete(::operator new(bytes)), std::bad_alloc);
+    ASSERT_EQ(2, calls);
+    std::set_new_handler(previous);
+}
+
+TEST(OperatorNewTests, can_delete_on_other_threads) {
+    std::vector<std::unique_ptr<std::string>> strings;
+    std::thread producer([&] {
+        for (size_t index = 0; index < 1000; index++)
+            strings.push_back(std::make_unique<std::string>(index, 'x'));
+    });
+    producer.join();
+
+    ASSERT_EQ(std::string(999, 'x'), *strings.back());
+    strings.clear();
+}
@@ -0,0 +1,69 @@
+#include <list>
+#include <map>
+#include <unordered_map>
+#include <gtest/gtest.h>
+#include <malunal/allocators.hpp>
+
+using namespace malunal::allocators;
+
+
+TEST(NodePoolTests, serves_nodes_from_chunks) {
+    arena_memory_resource arena;
+    node_pool_resource    pool(&arena);
+
+    std::pmr::list<int> list(&pool);
+    for (auto index = 0u; index < k_node_chunk_size; index++)
+        list.push_back(index);
+
+    ASSERT_EQ(1, pool.total_chunks());
+    ASSERT_EQ(2, arena.allocations()); // Free list counts as an allocation.
+
+    list.push_back(0);
+    ASSERT_EQ(2, pool.total_chunks());
+    ASSERT_EQ(3, arena.allocations());
+}
+
+TEST(NodePoolTests, reuses_freed_nodes) {
+    arena_memory_resource arena;
+    node_pool_resource    pool(&arena);
+
+    std::pmr::map<int, int> map(&pool);
+    for (auto round = 0; round < 8; round++) {
+        for (auto index = 0; index < 32; index++)
+            map.emplace(index, index);
+        map.clear();
+    }
+
+    ASSERT_EQ(1, pool.total_chunks());
+}
+
+TEST(NodePoolTests, keeps_size_classes_apart) {
+    node_pool_resource pool;
+
+    auto small = pool.allocate(8, 8);
+    auto large = pool.allocate(40, 8);
+    ASSERT_EQ(2, pool.total_chunks());
+    ASSERT_EQ(0, reinterpret_cast<uintptr_t>(large) % 8);
+
+    pool.deallocate(small, 8, 8);
+    ASSERT_EQ(small, pool.allocate(8, 8));
+
+    auto aligned = pool.allocate(24, 16);
+    ASSERT_EQ(0, reinterpret_cast<uintptr_t>(aligned) % 16);
+}
+
+TEST(NodePoolTests, passes_large_allocations_upstream) {
+    arena_memory_resource arena;
+    node_pool_resource    pool(&arena);
+
+    std::pmr::unordered_map<int, int> map(&pool);
+    map.reserve(1024); // Bucket array is larger than any node.
+    ASSERT_EQ(0, pool.total_chunks());
+    ASSERT_EQ(2, arena.allocations());
+
+    map.emplace(1, 1);
+    ASSERT_EQ(1, pool.total_chunks());
+
+    pool.release();
+    ASSERT_EQ(0, pool.total_chunks());
+}
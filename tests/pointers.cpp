@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+#include <malunal/allocators.hpp>
+
+using namespace malunal::allocators;
+
+
+struct tracked final {
+    explicit
+    tracked(int& destroyed) noexcept
+        : destroyed_{ destroyed }
+    { }
+
+    ~tracked() noexcept {
+        destroyed_++;
+    }
+
+private:
+    int& destroyed_;
+};
+
+
+TEST(PointerTests, unique_ptr_returns_memory) {
+    arena_memory_resource arena;
+    int destroyed = 0;
+    {
+        auto ptr = make_arena_unique<tracked>(&arena, destroyed);
+        ASSERT_NE(nullptr, ptr);
+        ASSERT_EQ(2, arena.allocations()); // Free list counts as an allocation.
+        ASSERT_EQ(2 * sizeof(void*), sizeof(ptr));
+    }
+
+    ASSERT_EQ(1, destroyed);
+    ASSERT_EQ(1, arena.allocations());
+}
+
+TEST(PointerTests, reclaimed_ptr_only_destroys) {
+    arena_memory_resource arena;
+    int destroyed = 0;
+    {
+        auto ptr = make_arena_reclaimed<tracked>(&arena, destroyed);
+        ASSERT_NE(nullptr, ptr);
+        ASSERT_EQ(sizeof(void*), sizeof(ptr));
+    }
+
+    ASSERT_EQ(1, destroyed);
+    ASSERT_EQ(2, arena.allocations()); // Memory waits for the reset.
+
+    arena.reset();
+    ASSERT_EQ(1, arena.allocations());
+    ASSERT_EQ(520, arena.total_used());
+}
+
+TEST(PointerTests, shared_ptr_uses_single_allocation) {
+    arena_memory_resource arena;
+    int destroyed = 0;
+    {
+        auto ptr  = allocate_shared_in<tracked>(&arena, destroyed);
+        auto copy = ptr;
+        ASSERT_EQ(2, arena.allocations());
+        ASSERT_EQ(2, copy.use_count());
+    }
+
+    ASSERT_EQ(1, destroyed);
+    ASSERT_EQ(1, arena.allocations());
+}
@@ -0,0 +1,78 @@
+#include <gtest/gtest.h>
+#include <malunal/allocators.hpp>
+
+using namespace malunal::allocators;
+
+
+TEST(HeapProfilerTests, samples_live_allocations) {
+    heap_profiler profiler(1);
+    arena_memory_resource arena;
+    profiling_resource resource(&profiler, &arena);
+
+    auto first  = resource.allocate(64, 8);
+    auto second = resource.allocate(128, 8);
+    ASSERT_EQ(2, profiler.live_samples());
+
+    resource.deallocate(first, 64, 8);
+    ASSERT_EQ(1, profiler.live_samples());
+    resource.deallocate(second, 128, 8);
+    ASSERT_EQ(0, profiler.live_samples());
+}
+
+TEST(HeapProfilerTests, samples_every_allocation_at_rate_one) {
+    heap_profiler profiler(1);
+    auto hooks = profiler.hooks();
+    std::vector<char> blocks(4096);
+    for (auto& block : blocks)
+        hooks.allocated(&block, 1, 1);
+
+    ASSERT_EQ(blocks.size(), profiler.live_samples());
+}
+
+TEST(HeapProfilerTests, drops_samples_sharing_a_filter_slot) {
+    heap_profiler profiler(1);
+    auto hooks = profiler.hooks();
+    std::vector<char> blocks(16384);
+    for (auto& block : blocks)
+        hooks.allocated(&block, 1, 1);
+
+    // Freeing pointers that were never sampled leaves the samples alone.
+    std::vector<char> others(16384);
+    for (auto& other : others)
+        hooks.deallocated(&other, 1, 1);
+    ASSERT_EQ(blocks.size(), profiler.live_samples());
+
+    for (auto& block : blocks)
+        hooks.deallocated(&block, 1, 1);
+    ASSERT_EQ(0, profiler.live_samples());
+}
+
+TEST(HeapProfilerTests, samples_by_rate) {
+    // At an average of one sample every 64 KiB, a MiB of small allocations
+    // is sampled roughly 16 times and never for every allocation.
+    heap_profiler profiler(64 * 1024);
+    auto hooks = profiler.hooks();
+    std::vector<char> blocks(16384);
+    for (auto& block : blocks)
+        hooks.allocated(&block, 64, 8);
+
+    ASSERT_LT(0, profiler.live_samples());
+    ASSERT_GT(64, profiler.live_samples());
+}
+
+TEST(HeapProfilerTests, writes_heap_profile) {
+    heap_profiler profiler(1);
+    auto hooks = profiler.hooks();
+    int value;
+    hooks.allocated(&value, sizeof(value), alignof(int));
+
+    auto file = std::tmpfile();
+    ASSERT_NE(nullptr, file);
+    ASSERT_TRUE(profiler.write_profile(file));
+
+    std::rewind(file);
+    char line[256]{};
+    ASSERT_NE(nullptr, std::fgets(line, sizeof(line), file));
+    std::fclose(file);
+    ASSERT_STREQ("heap profile: 1: 4 [1: 4] @ heap_v2/1\n", line);
+}
@@ -0,0 +1,33 @@
+#include <gtest/gtest.h>
+#include <malunal/allocators.hpp>
+
+using namespace malunal::allocators;
+
+
+TEST(ScratchBufferTests, try_allocate_without_upstream) {
+    alignas(16) std::byte   buffer[32];
+    scratch_buffer_resource scratch(buffer, sizeof(buffer));
+
+    ASSERT_NE(nullptr, scratch.try_allocate(32, 8));
+    ASSERT_EQ(nullptr, scratch.try_allocate(8, 8));
+    ASSERT_THROW((void)scratch.allocate(8, 8), std::bad_alloc);
+}
+
+TEST(ScratchBufferTests, overflows_to_upstream) {
+    alignas(16) std::byte   buffer[32];
+    arena_memory_resource   arena;
+    scratch_buffer_resource scratch(buffer, sizeof(buffer), &arena);
+
+    auto first  = scratch.try_allocate(32, 8);
+    auto second = scratch.try_allocate(8, 8);
+    auto third  = scratch.try_allocate(8, 8);
+    ASSERT_TRUE(scratch.owns(first));
+    ASSERT_TRUE(scratch.owns(second));
+    ASSERT_TRUE(arena.owns(second));
+    ASSERT_EQ(static_cast<std::byte*>(second) + 8, third); // Same new buffer.
+    ASSERT_EQ(2, arena.allocations()); // Free list counts as an allocation.
+
+    scratch.reset();
+    ASSERT_EQ(1, arena.allocations());
+    ASSERT_EQ(buffer, scratch.try_allocate(8, 8));
+}
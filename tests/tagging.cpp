@@ -0,0 +1,58 @@
+#include <gtest/gtest.h>
+#include <malunal/allocators.hpp>
+
+using namespace malunal::allocators;
+
+
+enum class subsystem : uint32_t {
+    audio,
+    render
+};
+
+
+TEST(AllocationTaggingTests, counts_user_tags) {
+    arena_memory_resource arena;
+    const auto audio  = allocation_tag(subsystem::audio);
+    const auto render = allocation_tag(subsystem::render);
+
+    auto first  = tagged_allocate(&arena, 64, 8, audio);
+    auto second = tagged_allocate(&arena, 128, 8, audio);
+    auto third  = tagged_allocate(&arena, 32, 8, render);
+    tagged_deallocate(&arena, second, 128, 8, audio);
+
+    const auto stats = audio.stats();
+    ASSERT_EQ(64, stats.bytes);
+    ASSERT_EQ(1, stats.live);
+    ASSERT_EQ(192, stats.peak);
+    ASSERT_EQ(2, stats.allocations);
+    ASSERT_EQ(static_cast<uint32_t>(subsystem::audio), stats.line);
+    ASSERT_EQ(32, render.stats().bytes);
+
+    // The same enumerator always finds the same counters.
+    ASSERT_EQ(64, allocation_tag(subsystem::audio).stats().bytes);
+
+    tagged_deallocate(&arena, first, 64, 8, audio);
+    tagged_deallocate(&arena, third, 32, 8, render);
+    ASSERT_EQ(0, audio.stats().live);
+}
+
+TEST(AllocationTaggingTests, counts_source_locations) {
+    arena_memory_resource arena;
+    tagged_resource resource(&arena);
+    {
+        std::pmr::vector<int> vec(&resource);
+        vec.resize(16);
+        ASSERT_EQ(16 * sizeof(int), resource.tag().stats().bytes);
+    }
+
+    const auto stats = resource.tag().stats();
+    ASSERT_EQ(0, stats.bytes);
+    ASSERT_EQ(16 * sizeof(int), stats.peak);
+    ASSERT_NE(nullptr, stats.file);
+    ASSERT_NE(nullptr, std::strstr(stats.file, "tagging.cpp"));
+
+    const auto all = tag_statistics();
+    ASSERT_TRUE(std::any_of(all.begin(), all.end(), [&](const tag_stats& tag) {
+        return tag.file == stats.file && tag.line == stats.line;
+    }));
+}
@@ -0,0 +1,137 @@
+#include <thread>
+#include <gtest/gtest.h>
+#include <malunal/allocators.hpp>
+
+using namespace malunal::allocators;
+
+
+TEST(ThreadCacheTests, can_allocate_memory) {
+    auto res = thread_cache_resource::try_allocate(100);
+    ASSERT_NE(nullptr, res);
+    ASSERT_EQ(0, reinterpret_cast<uintptr_t>(res) % k_thread_cache_alignment);
+    ASSERT_LE(100, thread_cache_resource::usable_size(res));
+
+    std::memset(res, 0xAB, 100);
+    thread_cache_resource::release(res);
+}
+
+TEST(ThreadCacheTests, can_reuse_cached_blocks) {
+    auto first = thread_cache_resource::try_allocate(48);
+    thread_cache_resource::release(first);
+
+    // The freed block is cached, and handed out again for the same size class.
+    auto second = thread_cache_resource::try_allocate(40);
+    ASSERT_EQ(first, second);
+    thread_cache_resource::release(second);
+}
+
+TEST(ThreadCacheTests, can_allocate_aligned_memory) {
+    for (const size_t alignment : { 32, 64, 256, 4096, 65536 }) {
+        auto res = thread_cache_resource::try_allocate(24, alignment);
+        ASSERT_NE(nullptr, res);
+        ASSERT_EQ(0, reinterpret_cast<uintptr_t>(res) % alignment);
+        ASSERT_LE(24, thread_cache_resource::usable_size(res));
+        thread_cache_resource::release(res);
+    }
+}
+
+TEST(ThreadCacheTests, can_allocate_mapped_memory) {
+    const auto bytes = k_thread_cache_mapped_threshold * 4;
+    auto res = static_cast<unsigned char*>(thread_cache_resource::try_allocate_zeroed(bytes));
+    ASSERT_NE(nullptr, res);
+    ASSERT_LE(bytes, thread_cache_resource::usable_size(res));
+    ASSERT_EQ(0, res[0]);
+    ASSERT_EQ(0, res[bytes - 1]);
+    thread_cache_resource::release(res);
+}
+
+TEST(ThreadCacheTests, can_allocate_zeroed_memory) {
+    auto first = static_cast<unsigned char*>(thread_cache_resource::try_allocate(64));
+    std::memset(first, 0xFF, 64);
+    thread_cache_resource::release(first);
+
+    // The same block comes back from the cache, and must be cleared.
+    auto second = static_cast<unsigned char*>(thread_cache_resource::try_allocate_zeroed(64));
+    ASSERT_EQ(first, second);
+    ASSERT_TRUE(std::all_of(second, second + 64, [](auto value) { return value == 0; }));
+    thread_cache_resource::release(second);
+}
+
+TEST(ThreadCacheTests, can_reallocate_memory) {
+    auto res = static_cast<char*>(thread_cache_resource::try_allocate(16));
+    std::memcpy(res, "malunal", 8);
+
+    // Growing within the arena moves the block to a larger one.
+    res = static_cast<char*>(thread_cache_resource::try_reallocate(res, 1000));
+    ASSERT_STREQ("malunal", res);
+
+    // Growing past the threshold moves the block to its own pages.
+    res = static_cast<char*>(thread_cache_resource::try_reallocate(res, k_thread_cache_mapped_threshold));
+    ASSERT_STREQ("malunal", res);
+    ASSERT_LE(k_thread_cache_mapped_threshold, thread_cache_resource::usable_size(res));
+
+    // Shrinking a little stays in place.
+    auto same = thread_cache_resource::try_reallocate(res, k_thread_cache_mapped_threshold - 16);
+    ASSERT_EQ(res, same);
+    thread_cache_resource::release(same);
+}
+
+TEST(ThreadCacheTests, can_deallocate_on_other_threads) {
+    std::vector<void*> blocks;
+    std::thread producer([&] {
+        for (size_t index = 0; index < 1000; index++)
+            blocks.push_back(thread_cache_resource::try_allocate(16 + index % 64));
+    });
+    producer.join();
+
+    // The producer exited, so its heap is adopted by the next thread and the
+    // blocks freed here are handed back to it.
+    for (auto block : blocks)
+        thread_cache_resource::release(block);
+
+    // The first allocation of the consumer returns the blocks freed remotely
+    // to the adopted heap, and reuses one of them.
+    void* reused = nullptr;
+    std::thread consumer([&] {
+        reused = thread_cache_resource::try_allocate(32);
+        thread_cache_resource::release(reused);
+    });
+    consumer.join();
+    ASSERT_NE(blocks.end(), std::find(blocks.begin(), blocks.end(), reused));
+}
+
+TEST(ThreadCacheTests, maps_memory_after_thread_exit) {
+    // Constructed before the thread acquires its heap, so it is destroyed
+    // after the heap was handed over.
+    struct late_allocator final {
+        size_t* usable;
+
+        ~late_allocator() noexcept {
+            auto res = thread_cache_resource::try_allocate(16);
+            *usable  = thread_cache_resource::usable_size(res);
+            thread_cache_resource::release(res);
+        }
+    };
+
+    size_t usable = 0;
+    std::thread thread([&] {
+        thread_local late_allocator k_late{ nullptr };
+        k_late.usable = &usable;
+        thread_cache_resource::release(thread_cache_resource::try_allocate(16));
+    });
+    thread.join();
+
+    // Instead of acquiring a heap which would never be handed over again, the
+    // block is mapped.
+    ASSERT_LE(page_resource::page_size() - k_thread_cache_alignment, usable);
+}
+
+TEST(ThreadCacheTests, can_allocate_through_resource) {
+    std::pmr::vector<std::pmr::string> strings(thread_cache_instance());
+    for (size_t index = 0; index < 100; index++)
+        strings.emplace_back(std::string(index, 'x'));
+
+    ASSERT_EQ(100, strings.size());
+    ASSERT_EQ(std::string(99, 'x'), std::string_view(strings.back()));
+    ASSERT_TRUE(thread_cache_instance()->is_equal(thread_cache_resource()));
+}
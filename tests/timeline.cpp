@@ -0,0 +1,40 @@
+#include <gtest/gtest.h>
+#include <malunal/allocators.hpp>
+
+using namespace malunal::allocators;
+
+
+TEST(ArenaEventLogTests, records_arena_activity) {
+    arena_memory_resource arena;
+    arena_event_log log(arena, std::chrono::nanoseconds(0));
+    arena.set_hooks(log.hooks());
+
+    log.begin("request");
+    (void)arena.allocate(k_max_alloc_size, 8);
+    arena.reset();
+    (void)arena.purge();
+    log.end("request");
+    arena.set_hooks(allocation_hooks{});
+
+    // Phase begin, growth, counter, reset, purge and phase end.
+    ASSERT_EQ(6, log.size());
+
+    auto file = std::tmpfile();
+    ASSERT_NE(nullptr, file);
+    ASSERT_TRUE(log.write(file));
+
+    std::rewind(file);
+    std::string json;
+    char buffer[256];
+    while (std::fgets(buffer, sizeof(buffer), file) != nullptr)
+        json += buffer;
+    std::fclose(file);
+
+    ASSERT_EQ(0, json.find("{\"displayTimeUnit\":\"ns\",\"traceEvents\":["));
+    ASSERT_NE(std::string::npos, json.find("\"name\":\"request\",\"cat\":\"arena\",\"ph\":\"B\""));
+    ASSERT_NE(std::string::npos, json.find("\"name\":\"region_acquire\""));
+    ASSERT_NE(std::string::npos, json.find("\"name\":\"arena\",\"cat\":\"arena\",\"ph\":\"C\""));
+    ASSERT_NE(std::string::npos, json.find("\"name\":\"reset\""));
+    ASSERT_NE(std::string::npos, json.find("\"name\":\"purge\""));
+    ASSERT_NE(std::string::npos, json.find("\"ph\":\"E\""));
+}
@@ -0,0 +1,48 @@
+#include <gtest/gtest.h>
+#include <malunal/allocators.hpp>
+
+using namespace malunal::allocators;
+
+
+TEST(AllocationTraceTests, records_and_replays) {
+    auto file = std::tmpfile();
+    ASSERT_NE(nullptr, file);
+
+    arena_memory_resource arena;
+    {
+        recording_resource recorder(&arena, file);
+        std::pmr::vector<int> vec(&recorder);
+        for (auto index = 0; index < 64; index++)
+            vec.push_back(index);
+        ASSERT_TRUE(recorder.is_open());
+        ASSERT_LT(0, recorder.records());
+    }
+
+    std::rewind(file);
+    const auto records = read_trace(file);
+    std::fclose(file);
+
+    // Every allocation of the vector is deallocated again.
+    ASSERT_FALSE(records.empty());
+    ASSERT_EQ(0, records.size() % 2);
+    ASSERT_EQ(trace_operation::allocate, records.front().operation);
+    ASSERT_EQ(trace_operation::deallocate, records.back().operation);
+    ASSERT_EQ(alignof(int), records.front().alignment);
+    for (auto index = 1u; index < records.size(); index++)
+        ASSERT_LE(records[index - 1].timestamp, records[index].timestamp);
+
+    arena_memory_resource target;
+    ASSERT_EQ(records.size(), replay_trace(records, &target));
+    ASSERT_EQ(1, target.allocations()); // Free list counts as an allocation.
+    ASSERT_LT(target.total_used(), target.stats().peak_used);
+}
+
+TEST(AllocationTraceTests, rejects_foreign_files) {
+    auto file = std::tmpfile();
+    ASSERT_NE(nullptr, file);
+    std::fputs("not an allocation trace", file);
+    std::rewind(file);
+
+    ASSERT_TRUE(read_trace(file).empty());
+    std::fclose(file);
+}